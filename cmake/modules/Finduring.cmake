@@ -2,13 +2,33 @@
 #
 # URING_INCLUDE_DIR - Where to find liburing.h
 # URING_LIBRARIES - List of libraries when using uring.
+# URING_VERSION - liburing version, 0 if older than 2.4.
 # uring_FOUND - True if uring found.
 
 find_path(URING_INCLUDE_DIR liburing.h)
 find_library(URING_LIBRARIES liburing.a liburing)
 
+# liburing/io_uring_version.h first shipped with liburing 2.4, report
+# anything older as version 0 so that a versioned find_package() fails
+set(URING_VERSION 0)
+set(_uring_version_h "${URING_INCLUDE_DIR}/liburing/io_uring_version.h")
+if(URING_INCLUDE_DIR AND EXISTS "${_uring_version_h}")
+  file(STRINGS "${_uring_version_h}" _uring_major
+    REGEX "^#define IO_URING_VERSION_MAJOR[ \t]+[0-9]+")
+  file(STRINGS "${_uring_version_h}" _uring_minor
+    REGEX "^#define IO_URING_VERSION_MINOR[ \t]+[0-9]+")
+  string(REGEX REPLACE ".*[ \t]([0-9]+)$" "\\1" _uring_major "${_uring_major}")
+  string(REGEX REPLACE ".*[ \t]([0-9]+)$" "\\1" _uring_minor "${_uring_minor}")
+  set(URING_VERSION "${_uring_major}.${_uring_minor}")
+  unset(_uring_major)
+  unset(_uring_minor)
+endif()
+unset(_uring_version_h)
+
 include(FindPackageHandleStandardArgs)
-find_package_handle_standard_args(uring DEFAULT_MSG URING_LIBRARIES URING_INCLUDE_DIR)
+find_package_handle_standard_args(uring
+  REQUIRED_VARS URING_LIBRARIES URING_INCLUDE_DIR
+  VERSION_VAR URING_VERSION)
 
 if(uring_FOUND AND NOT TARGET uring::uring)
   add_library(uring::uring UNKNOWN IMPORTED)
@@ -6,9 +6,22 @@
 
 class DummyAuthClientServer : public AuthClient,
 			      public AuthServer {
+  uint32_t con_mode = CEPH_CON_MODE_CRC;
+
+  // In secure mode both ends derive the session keys from this
+  // well-known secret, which is enough to benchmark or test the
+  // on-wire encryption but obviously provides no security at all.
+  static std::string get_connection_secret() {
+    return std::string(64, 'x');
+  }
+
 public:
   DummyAuthClientServer(CephContext *cct) : AuthServer(cct) {}
 
+  void set_con_mode(uint32_t mode) {
+    con_mode = mode;
+  }
+
   // client
   int get_auth_request(
     Connection *con,
@@ -17,7 +30,7 @@ public:
     std::vector<uint32_t> *preferred_modes,
     bufferlist *out) override {
     *method = CEPH_AUTH_NONE;
-    *preferred_modes = { CEPH_CON_MODE_CRC };
+    *preferred_modes = { con_mode };
     return 0;
   }
 
@@ -37,6 +50,9 @@ public:
     const bufferlist& bl,
     CryptoKey *session_key,
     std::string *connection_secret) {
+    if (con_mode == CEPH_CON_MODE_SECURE) {
+      *connection_secret = get_connection_secret();
+    }
     return 0;
   }
 
@@ -51,6 +67,18 @@ public:
   }
 
   // server
+  uint32_t pick_con_mode(
+    int peer_type,
+    uint32_t auth_method,
+    const std::vector<uint32_t>& preferred_modes) override {
+    for (auto mode : preferred_modes) {
+      if (mode == con_mode) {
+	return mode;
+      }
+    }
+    return CEPH_CON_MODE_UNKNOWN;
+  }
+
   int handle_auth_request(
     Connection *con,
     AuthConnectionMeta *auth_meta,
@@ -58,6 +86,9 @@ public:
     uint32_t auth_method,
     const bufferlist& bl,
     bufferlist *reply) override {
+    if (auth_meta->con_mode == CEPH_CON_MODE_SECURE) {
+      auth_meta->connection_secret = get_connection_secret();
+    }
     return 1;
   }
 };
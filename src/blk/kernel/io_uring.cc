@@ -134,12 +134,9 @@ int ioring_queue_t::init(std::vector<int> &fds)
   if (ret < 0)
     return ret;
 
-  ret = io_uring_register(d->io_uring.ring_fd, IORING_REGISTER_FILES,
-			  &fds[0], fds.size());
-  if (ret < 0) {
-    ret = -errno;
+  ret = io_uring_register_files(&d->io_uring, &fds[0], fds.size());
+  if (ret < 0)
     goto close_ring_fd;
-  }
 
   build_fixed_fds_map(d.get(), fds);
 
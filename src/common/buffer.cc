@@ -77,6 +77,93 @@ static ceph::spinlock debug_lock;
     return buffer_missed_crc;
   }
 
+  /*
+   * A per-thread cache of freed memory blocks of one size, for the
+   * ptr_nodes that every encode allocates and every message send or
+   * receive frees again.  A block goes to the cache of the thread
+   * freeing it, whichever thread allocated it; the cache only hands
+   * blocks out and takes them back, allocating and freeing them is up to
+   * the caller.  With seastar the allocator is per shard already, so
+   * nothing is cached there.
+   */
+#if !defined(WITH_SEASTAR) || defined(WITH_ALIEN)
+  // false until initialized, so nothing is cached during static init
+  static const bool buffer_thread_cache =
+    !get_env_bool("CEPH_BUFFER_NO_THREAD_CACHE");
+#else
+  static constexpr bool buffer_thread_cache = false;
+#endif
+
+  template <class Tag, unsigned Max>
+  class thread_block_cache {
+    struct block_t {
+      block_t* next;
+    };
+    // trivially destructible, so still usable while the thread exits
+    struct cache_t {
+      block_t* head = nullptr;
+      unsigned count = 0;
+      bool exiting = false;
+    };
+    static inline thread_local cache_t cache;
+    // blocks freed by exiting threads
+    static inline ceph::atomic<unsigned> reclaimed{0};
+    struct reaper_t {
+      bool armed = false;
+      ~reaper_t() {
+	cache.exiting = true;
+	reclaimed += cache.count;
+	while (cache.head) {
+	  Tag::free(std::exchange(cache.head, cache.head->next));
+	}
+	cache.count = 0;
+      }
+    };
+    static inline thread_local reaper_t reaper;
+
+  public:
+    static unsigned get_count() {
+      return cache.count;
+    }
+    static unsigned get_reclaimed() {
+      return reclaimed;
+    }
+    static void* get() {
+      if (auto* b = cache.head; b) {
+	cache.head = b->next;
+	--cache.count;
+	return b;
+      }
+      return nullptr;
+    }
+    static bool put(void* p) {
+      if (!buffer_thread_cache || cache.count >= Max || cache.exiting) {
+	return false;
+      }
+      if (!cache.head) {
+	// have the cache emptied when the thread exits
+	reaper.armed = true;
+      }
+      cache.head = new (p) block_t{cache.head};
+      ++cache.count;
+      return true;
+    }
+  };
+
+  struct ptr_node_block {
+    static void free(void* p) {
+      ::operator delete(p);
+    }
+  };
+  using ptr_node_cache = thread_block_cache<ptr_node_block, 256>;
+
+  int buffer::get_thread_cached_nodes() {
+    return ptr_node_cache::get_count();
+  }
+  int buffer::get_reclaimed_nodes() {
+    return ptr_node_cache::get_reclaimed();
+  }
+
   /*
    * raw_combined is always placed within a single allocation along
    * with the data buffer.  the data goes at the beginning, and
@@ -2147,6 +2234,22 @@ buffer::list buffer::list::static_from_string(string& s) {
   // const makes me generally sad.
 }
 
+void* buffer::ptr_node::operator new(size_t size)
+{
+  ceph_assert(size == sizeof(ptr_node));
+  if (void* p = ptr_node_cache::get(); p) {
+    return p;
+  }
+  return ::operator new(size);
+}
+
+void buffer::ptr_node::operator delete(void* p)
+{
+  if (!ptr_node_cache::put(p)) {
+    ::operator delete(p);
+  }
+}
+
 bool buffer::ptr_node::dispose_if_hypercombined(
   buffer::ptr_node* const delete_this)
 {
@@ -962,6 +962,28 @@ std::vector<Option> get_global_options() {
     .set_default(4_K)
     .set_description("Maximum amount of data to prefetch out of the socket receive buffer"),
 
+    Option("ms_async_write_coalesce_bytes", Option::TYPE_SIZE, Option::LEVEL_ADVANCED)
+    .set_default(64_K)
+    .set_description("Gather the frames of queued messages into writes of up to this size")
+    .set_long_description("When more messages are queued on a connection, "
+      "the frames of the ones written so far are sent together with the "
+      "following ones, up to this many bytes, saving a system call per "
+      "message for streams of small messages such as heartbeats and "
+      "replication acks. No message is held back waiting for others to be "
+      "queued. 0 sends every message on its own.")
+    .add_see_also("ms_async_write_coalesce_time_us"),
+
+    Option("ms_async_write_coalesce_time_us", Option::TYPE_UINT, Option::LEVEL_DEV)
+    .set_default(50)
+    .set_description("Maximum time frames gathered for a write may wait for the following ones, in microseconds")
+    .add_see_also("ms_async_write_coalesce_bytes"),
+
+    Option("ms_tcp_zerocopy_min_size", Option::TYPE_SIZE, Option::LEVEL_ADVANCED)
+    .set_default(0)
+    .set_flag(Option::FLAG_STARTUP)
+    .set_description("Send writes of at least this size with MSG_ZEROCOPY (0 to disable)")
+    .set_long_description("Applies to the posix async messenger stack on Linux 4.14 and later.  The kernel pins the sent pages instead of copying them and reports when it is done; the messenger holds the buffers until then.  Only worth it for large payloads, e.g. 64K and up, and it turns itself off for a connection once the kernel reports having copied anyway (loopback, NICs without scatter-gather)."),
+
     Option("ms_initial_backoff", Option::TYPE_FLOAT, Option::LEVEL_ADVANCED)
     .set_default(.2)
     .set_description("Initial backoff after a network error is detected (seconds)"),
@@ -1003,6 +1025,18 @@ std::vector<Option> get_global_options() {
     .set_default(100_M)
     .set_description("Limit messages that are read off the network but still being processed"),
 
+    Option("ms_dispatch_inline_types", Option::TYPE_STR, Option::LEVEL_DEV)
+    .set_default("")
+    .set_flag(Option::FLAG_STARTUP)
+    .set_description("Message types the receiving thread may dispatch itself")
+    .set_long_description("A list of numeric message types (e.g. 19 for "
+      "MMonGetVersion). When a message of one of these types is received while "
+      "the dispatch thread is idle and has nothing queued, the messenger "
+      "thread that read it calls ms_dispatch() directly instead of waking "
+      "up the dispatch thread. ms_dispatch() calls are still serialized, "
+      "but while one is running the messenger thread can't service its "
+      "other connections, so only list types whose handling is quick."),
+
     Option("ms_bind_ipv4", Option::TYPE_BOOL, Option::LEVEL_ADVANCED)
     .set_default(true)
     .set_description("Bind servers to IPv4 address(es)")
@@ -1210,6 +1244,33 @@ std::vector<Option> get_global_options() {
     .set_default("ib")
     .set_description(""),
 
+    Option("ms_async_uring_queue_depth", Option::TYPE_UINT, Option::LEVEL_ADVANCED)
+    .set_default(1024)
+    .set_flag(Option::FLAG_STARTUP)
+    .set_description("Submission queue depth of the io_uring of each messenger worker (ms_type=async+uring)")
+    .add_see_also("ms_type"),
+
+    Option("ms_async_uring_recv_buffers", Option::TYPE_UINT, Option::LEVEL_ADVANCED)
+    .set_default(256)
+    .set_flag(Option::FLAG_STARTUP)
+    .set_description("Number of buffers each messenger worker provides to io_uring for receiving (ms_type=async+uring)")
+    .set_long_description("Must be a power of two.")
+    .add_see_also("ms_async_uring_recv_buffer_size"),
+
+    Option("ms_async_uring_recv_buffer_size", Option::TYPE_SIZE, Option::LEVEL_ADVANCED)
+    .set_default(16_K)
+    .set_flag(Option::FLAG_STARTUP)
+    .set_description("Size of each buffer provided to io_uring for receiving (ms_type=async+uring)")
+    .add_see_also("ms_async_uring_recv_buffers"),
+
+    Option("ms_async_uring_recv_queue_max", Option::TYPE_SIZE, Option::LEVEL_ADVANCED)
+    .set_default(4_M)
+    .set_description("Stop receiving on a connection while this much received data is waiting to be read (ms_type=async+uring)"),
+
+    Option("ms_async_uring_send_queue_max", Option::TYPE_SIZE, Option::LEVEL_ADVANCED)
+    .set_default(4_M)
+    .set_description("Stop accepting data to send on a connection while this much is waiting to go out (ms_type=async+uring)"),
+
     Option("ms_dpdk_port_id", Option::TYPE_INT, Option::LEVEL_ADVANCED)
     .set_default(0)
     .set_description(""),
@@ -1398,6 +1459,12 @@ std::vector<Option> get_global_options() {
     .add_service("mon")
     .set_description("granularity of PG placement calculation background work"),
 
+    Option("mon_osd_mapping_incremental", Option::TYPE_BOOL, Option::LEVEL_DEV)
+    .set_default(true)
+    .add_service("mon")
+    .set_description("only recalculate placement of PGs an OSDMap incremental can affect")
+    .set_long_description("When an incremental only changes pg_temp, primary_temp, upmaps, primary affinity or marks OSDs down, recalculate just the PGs involved instead of every PG in the cluster."),
+
     Option("mon_clean_pg_upmaps_per_chunk", Option::TYPE_UINT, Option::LEVEL_DEV)
     .set_default(256)
     .add_service("mon")
@@ -2361,6 +2428,13 @@ std::vector<Option> get_global_options() {
     .set_default(32)
     .set_description(""),
 
+    Option("objecter_rwlock_shards", Option::TYPE_UINT, Option::LEVEL_ADVANCED)
+    .set_default(16)
+    .set_min(1)
+    .set_flag(Option::FLAG_STARTUP)
+    .set_description("Number of shards the objecter's map/session lock is split into")
+    .set_long_description("Every op submit and reply takes this lock shared; each thread only touches its own shard, so more shards let clients with many threads scale, at the cost of map updates having to take every shard.  Builds with lockdep (CEPH_DEBUG_MUTEX) use a single lock and ignore this."),
+
     Option("objecter_inject_no_watch_ping", Option::TYPE_BOOL, Option::LEVEL_DEV)
     .set_default(false)
     .set_description(""),
@@ -2976,6 +3050,12 @@ std::vector<Option> get_global_options() {
     .set_default(512)
     .set_description(""),
 
+    Option("osd_backfill_scan_prefetch", Option::TYPE_BOOL, Option::LEVEL_ADVANCED)
+    .set_default(true)
+    .set_description("Request the next scan interval from backfill targets before the current one is used up")
+    .set_long_description("When enabled, the primary asks each backfill target for its next interval of objects as soon as it starts working on the current one, so that backfill does not stall for a network round trip every osd_backfill_scan_max objects.")
+    .add_see_also("osd_backfill_scan_max"),
+
     Option("osd_op_thread_timeout", Option::TYPE_INT, Option::LEVEL_ADVANCED)
     .set_default(15)
     .set_description(""),
@@ -3062,6 +3142,17 @@ std::vector<Option> get_global_options() {
     .set_default(2)
     .set_description(""),
 
+    Option("osd_snap_trim_latency_target", Option::TYPE_FLOAT, Option::LEVEL_ADVANCED)
+    .set_default(0)
+    .set_description("Client op latency (in seconds) snap trimming should try to stay under")
+    .set_long_description("When the average client op latency measured over an OSD tick exceeds this target, snap trimming is throttled: fewer objects are trimmed concurrently per PG and an extra delay of up to osd_snap_trim_adaptive_sleep_max is added between batches. The throttle is relaxed again once latency drops below half the target. 0 disables adaptive throttling.")
+    .add_see_also({"osd_snap_trim_adaptive_sleep_max", "osd_pg_max_concurrent_snap_trims"}),
+
+    Option("osd_snap_trim_adaptive_sleep_max", Option::TYPE_FLOAT, Option::LEVEL_ADVANCED)
+    .set_default(1.0)
+    .set_description("Maximum extra delay between snap trim batches when throttled for client latency")
+    .add_see_also("osd_snap_trim_latency_target"),
+
     Option("osd_max_trimming_pgs", Option::TYPE_UINT, Option::LEVEL_ADVANCED)
     .set_default(2)
     .set_description(""),
@@ -3149,6 +3240,18 @@ std::vector<Option> get_global_options() {
     .set_default(8_M)
     .set_description(""),
 
+    Option("osd_recovery_block_hash_size", Option::TYPE_SIZE, Option::LEVEL_ADVANCED)
+    .set_default(64_K)
+    .set_description("Block size used to compare object data with a replica before pushing it")
+    .set_long_description("Before pushing an object to a replica that holds an older copy of it, the primary asks for a hash of each block of this size of that copy and only pushes the blocks that differ. 0 disables the comparison.")
+    .add_see_also("osd_recovery_block_hash_min_size"),
+
+    Option("osd_recovery_block_hash_min_size", Option::TYPE_SIZE, Option::LEVEL_ADVANCED)
+    .set_default(1_M)
+    .set_description("Minimum amount of object data to push before comparing block hashes with the replica")
+    .set_long_description("Smaller pushes are sent whole, as the extra round trip costs more than it can save. Objects larger than osd_recovery_max_chunk are always sent whole.")
+    .add_see_also("osd_recovery_block_hash_size"),
+
     Option("osd_recovery_max_omap_entries_per_chunk", Option::TYPE_UINT, Option::LEVEL_ADVANCED)
     .set_default(8096)
     .set_description(""),
@@ -3250,6 +3353,17 @@ std::vector<Option> get_global_options() {
     .add_see_also("osd_scrub_begin_week_day")
     .add_see_also("osd_scrub_end_week_day"),
 
+    Option("osd_scrub_latency_target", Option::TYPE_FLOAT, Option::LEVEL_ADVANCED)
+    .set_default(0)
+    .set_description("Client op latency (in seconds) scrubbing should try to stay under")
+    .set_long_description("When the average client op latency measured over an OSD tick exceeds this target, scheduled scrubs are throttled: chunks get smaller and an extra delay of up to osd_scrub_adaptive_sleep_max is added between them. The throttle is relaxed again once latency drops below half the target. 0 disables adaptive throttling.")
+    .add_see_also("osd_scrub_adaptive_sleep_max"),
+
+    Option("osd_scrub_adaptive_sleep_max", Option::TYPE_FLOAT, Option::LEVEL_ADVANCED)
+    .set_default(1.0)
+    .set_description("Maximum extra delay between scrub chunks when throttled for client latency")
+    .add_see_also("osd_scrub_latency_target"),
+
     Option("osd_scrub_auto_repair", Option::TYPE_BOOL, Option::LEVEL_ADVANCED)
     .set_default(false)
     .set_description("Automatically repair damaged objects detected during scrub"),
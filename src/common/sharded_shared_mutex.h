@@ -0,0 +1,91 @@
+// -*- mode:C++; tab-width:8; c-basic-offset:2; indent-tabs-mode:t -*-
+// vim: ts=8 sw=2 smarttab
+
+#ifndef CEPH_COMMON_SHARDED_SHARED_MUTEX_H
+#define CEPH_COMMON_SHARDED_SHARED_MUTEX_H
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <shared_mutex>
+
+namespace ceph {
+
+// A shared_mutex for read-mostly state that is read on every request
+// by many threads at once.  A plain shared_mutex keeps all of its
+// readers in one word, so even uncontended shared locking bounces that
+// cache line between every core taking it.  Here each thread takes the
+// shared side of only its own shard, while exclusive lockers take every
+// shard in order.
+//
+// Meets the Lockable and SharedLockable requirements, so it works with
+// unique_lock, shared_lock and shunique_lock.  A shared lock must be
+// released by the thread that acquired it; an exclusive one may not be
+// held while taking a shared one on the same thread.
+
+class sharded_shared_mutex {
+  struct alignas(64) shard_t {  // keep each shard on its own cache line
+    std::shared_mutex m;
+  };
+
+  size_t num_shards;
+  std::unique_ptr<shard_t[]> shards;
+
+  static size_t thread_index() {
+    static std::atomic<size_t> next_index{0};
+    thread_local size_t index = next_index++;
+    return index;
+  }
+  shard_t& my_shard() {
+    return shards[thread_index() % num_shards];
+  }
+
+public:
+  explicit sharded_shared_mutex(size_t n)
+    : num_shards(n ? n : 1),
+      shards(new shard_t[num_shards]) {}
+  sharded_shared_mutex(const sharded_shared_mutex&) = delete;
+  sharded_shared_mutex& operator =(const sharded_shared_mutex&) = delete;
+
+  size_t get_num_shards() const {
+    return num_shards;
+  }
+
+  // exclusive
+  void lock() {
+    for (size_t i = 0; i < num_shards; ++i) {
+      shards[i].m.lock();
+    }
+  }
+  bool try_lock() {
+    for (size_t i = 0; i < num_shards; ++i) {
+      if (!shards[i].m.try_lock()) {
+	while (i > 0) {
+	  shards[--i].m.unlock();
+	}
+	return false;
+      }
+    }
+    return true;
+  }
+  void unlock() {
+    for (size_t i = num_shards; i > 0; --i) {
+      shards[i - 1].m.unlock();
+    }
+  }
+
+  // shared
+  void lock_shared() {
+    my_shard().m.lock_shared();
+  }
+  bool try_lock_shared() {
+    return my_shard().m.try_lock_shared();
+  }
+  void unlock_shared() {
+    my_shard().m.unlock_shared();
+  }
+};
+
+} // namespace ceph
+
+#endif // CEPH_COMMON_SHARDED_SHARED_MUTEX_H
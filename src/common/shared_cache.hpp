@@ -277,6 +277,12 @@ public:
     std::list<VPtr> to_release;
     {
       std::unique_lock l{lock};
+      // anything on the lru is pinned by it, so a hot key can skip the
+      // ordered weak_refs lookup and never has to wait for a cleanup
+      if (auto i = contents.find(key); i != contents.end()) {
+	lru.splice(lru.begin(), lru, i->second);
+	return i->second->second;
+      }
       ++waiting;
       cond.wait(l, [this, &key, &val, &to_release] {
         if (auto i = weak_refs.find(key); i != weak_refs.end()) {
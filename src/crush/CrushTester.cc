@@ -2,6 +2,7 @@
 // vim: ts=8 sw=2 smarttab
 
 #include <algorithm>
+#include <chrono>
 #include <cstdlib>
 #include <iostream>
 
@@ -474,6 +475,39 @@ void CrushTester::check_overlapped_rules() const
   }
 }
 
+void CrushTester::benchmark_rule(int r, int nr, const vector<__u32>& weight)
+{
+  using clock = std::chrono::steady_clock;
+  vector<int> xs;
+  xs.reserve(max_x - min_x + 1);
+  for (int x = min_x; x <= max_x; x++) {
+    uint32_t real_x = x;
+    if (pool_id != -1) {
+      real_x = crush_hash32_2(CRUSH_HASH_RJENKINS1, x, (uint32_t)pool_id);
+    }
+    xs.push_back(real_x);
+  }
+
+  // report the fastest of a few passes, so that runs of crushtool built
+  // from different trees can be compared
+  vector<int> out;
+  std::chrono::duration<double> elapsed = std::chrono::duration<double>::max();
+  for (int pass = 0; pass < 5; pass++) {
+    auto start = clock::now();
+    for (auto x : xs) {
+      crush.do_rule(r, x, out, nr, weight, 0);
+    }
+    elapsed = std::min<std::chrono::duration<double>>(elapsed,
+						       clock::now() - start);
+  }
+
+  err << "rule " << r << " (" << crush.get_rule_name(r) << ") num_rep " << nr
+      << " benchmark: " << xs.size() << " mappings in " << elapsed.count()
+      << " sec, "
+      << (elapsed.count() > 0 ? (double)xs.size() / elapsed.count() : 0.0)
+      << " mappings/sec" << std::endl;
+}
+
 int CrushTester::test()
 {
   if (min_rule < 0 || max_rule < 0) {
@@ -540,6 +574,9 @@ int CrushTester::test()
       << std::endl;
 
     for (int nr = minr; nr <= maxr; nr++) {
+      if (output_benchmark && use_crush)
+	benchmark_rule(r, nr, weight);
+
       vector<int> per(crush.get_max_devices());
       map<int,int> sizes;
 
@@ -120,6 +120,28 @@ __u32 crush_hash32_3(int type, __u32 a, __u32 b, __u32 c)
 	}
 }
 
+/*
+ * Hash (a, b[i], c) for each of the n entries of b.  The loop body is
+ * the inlined, branch-free mix, so the compiler can evaluate several
+ * lanes at once; each out[i] equals crush_hash32_3(type, a, b[i], c).
+ */
+void crush_hash32_3_multi(int type, __u32 a, const __s32 *b, __u32 c,
+			  __u32 *out, unsigned int n)
+{
+	unsigned int i;
+
+	switch (type) {
+	case CRUSH_HASH_RJENKINS1:
+		for (i = 0; i < n; i++)
+			out[i] = crush_hash32_rjenkins1_3(a, (__u32)b[i], c);
+		break;
+	default:
+		for (i = 0; i < n; i++)
+			out[i] = 0;
+		break;
+	}
+}
+
 __u32 crush_hash32_4(int type, __u32 a, __u32 b, __u32 c, __u32 d)
 {
 	switch (type) {
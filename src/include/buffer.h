@@ -117,6 +117,10 @@ struct error_code;
   int get_missed_crc();
   /// enable/disable tracking of cached crcs
   void track_cached_crc(bool b);
+  /// count of freed ptr_nodes the calling thread keeps for reuse
+  int get_thread_cached_nodes();
+  /// count of cached ptr_nodes freed by threads as they exited
+  int get_reclaimed_nodes();
 
   /*
    * an abstract raw buffer.  with a reference count.
@@ -388,6 +392,10 @@ struct error_code;
 
     static ptr_node* copy_hypercombined(const ptr_node& copy_this);
 
+    // nodes come from a per-thread cache of the ones freed recently
+    static void* operator new(size_t size);
+    static void operator delete(void* p);
+
   private:
     template <class... Args>
     ptr_node(Args&&... args) : ptr(std::forward<Args>(args)...) {
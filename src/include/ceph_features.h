@@ -108,6 +108,7 @@ DEFINE_CEPH_FEATURE_RETIRED(19, 1, CHUNKY_SCRUB, JEWEL, LUMINOUS)
 DEFINE_CEPH_FEATURE(19, 2, OSD_PGLOG_HARDLIMIT)
 DEFINE_CEPH_FEATURE_RETIRED(20, 1, MON_NULLROUTE, JEWEL, LUMINOUS)
 DEFINE_CEPH_FEATURE(20, 3, SERVER_PACIFIC)
+DEFINE_CEPH_FEATURE(20, 3, OSD_RECOVERY_BLOCK_HASHES) // overlap
 DEFINE_CEPH_FEATURE_RETIRED(21, 1, MON_GV, HAMMER, JEWEL)
 DEFINE_CEPH_FEATURE(21, 2, SERVER_LUMINOUS)  // 4.13
 DEFINE_CEPH_FEATURE(21, 2, RESEND_ON_SPLIT)  // overlap
@@ -246,6 +247,7 @@ DEFINE_CEPH_FEATURE_DEPRECATED(63, 1, RESERVED_BROKEN, LUMINOUS) // client-facin
 	 CEPH_FEATUREMASK_SERVER_OCTOPUS | \
 	 CEPH_FEATUREMASK_OSD_REPOP_MLCOD | \
 	 CEPH_FEATUREMASK_SERVER_PACIFIC | \
+	 CEPH_FEATUREMASK_OSD_RECOVERY_BLOCK_HASHES | \
 	 0ULL)
 
 #define CEPH_FEATURES_SUPPORTED_DEFAULT  CEPH_FEATURES_ALL
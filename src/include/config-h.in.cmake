@@ -105,6 +105,9 @@
 /* DPDK conditional compilation */
 #cmakedefine HAVE_DPDK
 
+/* AsyncMessenger io_uring conditional compilation */
+#cmakedefine HAVE_ASYNC_URING
+
 /* PMEM_DEVICE (OSD) conditional compilation */
 #cmakedefine HAVE_BLUESTORE_PMEM
 
@@ -412,6 +412,44 @@ struct denc_traits<T, std::enable_if_t<!std::is_void_v<_denc::ExtType_t<T>>>>
   }
 };
 
+// memcpy-able types
+//
+// the types whose in-memory representation is their encoding, so that a
+// vector of them is encoded and decoded as a single copy.  a class may
+// opt in by specializing denc_memcpyable for itself if it has no padding
+// and encodes nothing but its members, in order and without a header:
+//
+//   template<> struct denc_memcpyable<foo_t> : denc_memcpyable<uint64_t> {};
+template<typename T, typename=void>
+struct denc_memcpyable : std::false_type {};
+
+// the little-endian types and single bytes, on any host
+template<typename T>
+struct denc_memcpyable<
+  T,
+  std::enable_if_t<
+    _denc::is_any_of<_denc::underlying_type_t<T>,
+		     ceph_le64, ceph_le32, ceph_le16, uint8_t
+#ifndef _CHAR_IS_SIGNED
+		       , int8_t
+#endif
+		     >>> : std::true_type {};
+
+// the integers on little-endian hosts, but bool: not every byte is a bool
+template<typename T>
+struct denc_memcpyable<
+  T,
+  std::enable_if_t<!std::is_void_v<_denc::ExtType_t<T>> &&
+		   !std::is_same_v<T, bool>>>
+#ifdef CEPH_BIG_ENDIAN
+  : std::false_type {};
+#else
+  : std::bool_constant<sizeof(T) == sizeof(_denc::ExtType_t<T>)> {};
+#endif
+
+template<typename T>
+inline constexpr bool denc_memcpyable_v = denc_memcpyable<T>::value;
+
 // varint
 //
 // high bit of each byte indicates another byte follows.
@@ -922,11 +960,19 @@ struct denc_traits<
 };
 
 namespace _denc {
+  template<typename C>
+  struct is_vector : std::false_type {};
+  template<typename T, typename A>
+  struct is_vector<std::vector<T, A>> : std::true_type {};
+
   template<template<class...> class C, typename Details, typename ...Ts>
   struct container_base {
   private:
     using container = C<Ts...>;
     using T = typename Details::T;
+    // copy a vector of memcpy-able elements in and out as a whole
+    static constexpr bool bulk =
+      is_vector<container>::value && denc_memcpyable_v<T>;
 
   public:
     using traits = denc_traits<T>;
@@ -999,6 +1045,11 @@ namespace _denc {
     // nohead
     static void encode_nohead(const container& s, ceph::buffer::list::contiguous_appender& p,
 			      uint64_t f = 0) {
+      if constexpr (bulk) {
+        const size_t len = s.size() * sizeof(T);
+        memcpy(p.get_pos_add(len), s.data(), len);
+        return;
+      }
       for (const T& e : s) {
         if constexpr (traits::featured) {
           denc(e, p, f);
@@ -1011,6 +1062,14 @@ namespace _denc {
 			      ceph::buffer::ptr::const_iterator& p,
 			      uint64_t f=0) {
       s.clear();
+      if constexpr (bulk) {
+        // consume first: it throws if num is more than there is
+        const size_t len = num * sizeof(T);
+        const char* src = p.get_pos_add(len);
+        s.resize(num);
+        memcpy(s.data(), src, len);
+        return;
+      }
       Details::reserve(s, num);
       while (num--) {
 	T t;
@@ -1023,6 +1082,15 @@ namespace _denc {
     decode_nohead(size_t num, container& s,
 		  ceph::buffer::list::const_iterator& p) {
       s.clear();
+      if constexpr (bulk) {
+        const size_t len = num * sizeof(T);
+        if (p.get_remaining() < len) {
+          throw ceph::buffer::end_of_buffer();
+        }
+        s.resize(num);
+        p.copy(len, reinterpret_cast<char*>(s.data()));
+        return;
+      }
       Details::reserve(s, num);
       while (num--) {
 	T t;
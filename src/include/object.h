@@ -152,6 +152,8 @@ struct denc_traits<snapid_t> {
     denc(o.val, p);
   }
 };
+template<>
+struct denc_memcpyable<snapid_t> : denc_memcpyable<uint64_t> {};
 
 inline std::ostream& operator<<(std::ostream& out, const snapid_t& s) {
   if (s == CEPH_NOSNAP)
@@ -793,6 +793,11 @@ void OSDMonitor::update_from_paxos(bool *need_bootstrap)
   // walk through incrementals
   MonitorDBStore::TransactionRef t;
   size_t tx_size = 0;
+  mapping_changed_pgs.reset();
+  if (mapping.get_epoch() == osdmap.get_epoch() &&
+      g_conf().get_val<bool>("mon_osd_mapping_incremental")) {
+    mapping_changed_pgs.emplace();
+  }
   while (version > osdmap.epoch) {
     bufferlist inc_bl;
     int err = get_version(osdmap.epoch+1, inc_bl);
@@ -815,6 +820,11 @@ void OSDMonitor::update_from_paxos(bool *need_bootstrap)
     OSDMap::Incremental inc(inc_bl);
     err = osdmap.apply_incremental(inc);
     ceph_assert(err == 0);
+    if (mapping_changed_pgs &&
+	!osdmap.get_incremental_mapping_pgs(inc, mapping,
+					    &*mapping_changed_pgs)) {
+      mapping_changed_pgs.reset();
+    }
 
     if (!t)
       t.reset(new MonitorDBStore::Transaction);
@@ -1020,10 +1030,20 @@ void OSDMonitor::start_mapping()
   }
   if (!osdmap.get_pools().empty()) {
     auto fin = new C_UpdateCreatingPGs(this, osdmap.get_epoch());
-    mapping_job = mapping.start_update(osdmap, mapper,
-				       g_conf()->mon_osd_mapping_pgs_per_chunk);
-    dout(10) << __func__ << " started mapping job " << mapping_job.get()
-	     << " at " << fin->start << dendl;
+    if (mapping_changed_pgs) {
+      mapping_job = mapping.start_update(osdmap, mapper,
+					 g_conf()->mon_osd_mapping_pgs_per_chunk,
+					 *mapping_changed_pgs);
+      dout(10) << __func__ << " started incremental mapping job "
+	       << mapping_job.get() << " for " << mapping_changed_pgs->size()
+	       << " pgs at " << fin->start << dendl;
+    } else {
+      mapping_job = mapping.start_update(osdmap, mapper,
+					 g_conf()->mon_osd_mapping_pgs_per_chunk);
+      dout(10) << __func__ << " started mapping job " << mapping_job.get()
+	       << " at " << fin->start << dendl;
+    }
+    mapping_changed_pgs.reset();
     mapping_job->set_finish_event(fin);
   } else {
     dout(10) << __func__ << " no pools, no mapping job" << dendl;
@@ -13968,7 +13988,7 @@ int OSDMonitor::_prepare_remove_pool(
     }
   }
   // remove any pg_upmap mappings for this pool
-  for (auto& p : osdmap.pg_upmap) {
+  for (auto& p : *osdmap.pg_upmap) {
     if (p.first.pool() == pool) {
       dout(10) << __func__ << " " << pool
                << " removing obsolete pg_upmap "
@@ -13991,7 +14011,7 @@ int OSDMonitor::_prepare_remove_pool(
     }
   }
   // remove any pg_upmap_items mappings for this pool
-  for (auto& p : osdmap.pg_upmap_items) {
+  for (auto& p : *osdmap.pg_upmap_items) {
     if (p.first.pool() == pool) {
       dout(10) << __func__ << " " << pool
                << " removing obsolete pg_upmap_items " << p.first
@@ -22,6 +22,7 @@
 #define CEPH_OSDMONITOR_H
 
 #include <map>
+#include <optional>
 #include <set>
 
 #include "include/types.h"
@@ -390,6 +391,8 @@ private:
   ParallelPGMapper mapper;                        ///< for background pg work
   OSDMapMapping mapping;                          ///< pg <-> osd mappings
   std::unique_ptr<ParallelPGMapper::Job> mapping_job;  ///< background mapping job
+  /// pgs to remap if the incrementals since the last mapping allow it
+  std::optional<std::set<pg_t>> mapping_changed_pgs;
   void start_mapping();
 
   void update_logger();
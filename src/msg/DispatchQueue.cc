@@ -16,6 +16,8 @@
 #include "DispatchQueue.h"
 #include "Messenger.h"
 #include "common/ceph_context.h"
+#include "common/perf_histogram.h"
+#include "include/str_list.h"
 
 #define dout_subsys ceph_subsys_ms
 #include "common/debug.h"
@@ -30,6 +32,92 @@ using ceph::ref_t;
 #undef dout_prefix
 #define dout_prefix *_dout << "-- " << msgr->get_myaddrs() << " "
 
+// band of the priority axis of dispatch_lat_histogram: one per
+// CEPH_MSG_PRIO_*, with anything in between rounded down
+static int64_t prio_band(int prio)
+{
+  if (prio >= CEPH_MSG_PRIO_HIGHEST)
+    return 3;
+  if (prio >= CEPH_MSG_PRIO_HIGH)
+    return 2;
+  if (prio >= CEPH_MSG_PRIO_DEFAULT)
+    return 1;
+  return 0;
+}
+
+DispatchQueue::DispatchQueue(CephContext *cct, Messenger *msgr,
+			     std::string &name)
+  : cct(cct), msgr(msgr),
+    lock(ceph::make_mutex("Messenger::DispatchQueue::lock" + name)),
+    mqueue(cct->_conf->ms_pq_max_tokens_per_priority,
+	   cct->_conf->ms_pq_min_cost),
+    dispatch_lock(
+      ceph::make_mutex("Messenger::DispatchQueue::dispatch_lock" + name)),
+    next_id(1),
+    dispatch_thread(this),
+    local_delivery_lock(ceph::make_mutex("Messenger::DispatchQueue::local_delivery_lock" + name)),
+    stop_local_delivery(false),
+    local_delivery_thread(this),
+    dispatch_throttler(cct, std::string("msgr_dispatch_throttler-") + name,
+		       cct->_conf->ms_dispatch_throttle_bytes),
+    stop(false)
+{
+  for (auto& t : get_str_list(
+	 cct->_conf.get_val<std::string>("ms_dispatch_inline_types"))) {
+    try {
+      inline_types.insert(std::stoi(t, nullptr, 0));
+    } catch (std::logic_error&) {
+      lderr(cct) << __func__ << " ignoring bad message type '" << t
+		 << "' in ms_dispatch_inline_types" << dendl;
+    }
+  }
+
+  PerfHistogramCommon::axis_config_d lat_axis_config{
+    "Latency (usec)",
+    PerfHistogramCommon::SCALE_LOG2,
+    0,
+    1000,   // 1 usec
+    32,
+  };
+  PerfHistogramCommon::axis_config_d prio_axis_config{
+    "Priority band",
+    PerfHistogramCommon::SCALE_LINEAR,
+    0,
+    1,
+    5,      // unused, LOW, DEFAULT, HIGH, HIGHEST (see prio_band())
+  };
+  PerfCountersBuilder plb(cct, std::string("msgr_dispatch_queue-") + name,
+			  l_dispatch_queue_first, l_dispatch_queue_last);
+  plb.add_u64_counter(l_dispatch_queue_fast_dispatch, "fast_dispatch",
+		      "Messages fast dispatched by the receiving thread");
+  plb.add_u64_counter(l_dispatch_queue_inline_dispatch, "inline_dispatch",
+		      "Messages dispatched by the receiving thread");
+  plb.add_u64_counter(l_dispatch_queue_queued_dispatch, "queued_dispatch",
+		      "Messages dispatched by the dispatch thread");
+  plb.add_time_avg(l_dispatch_queue_lat, "dispatch_lat",
+		   "Latency from receiving a message to dispatching it");
+  plb.add_u64_counter_histogram(
+    l_dispatch_queue_lat_histogram, "dispatch_lat_histogram",
+    lat_axis_config, prio_axis_config,
+    "Histogram of latency from receiving a message to dispatching it, "
+    "by priority");
+  logger = plb.create_perf_counters();
+  cct->get_perfcounters_collection()->add(logger);
+}
+
+DispatchQueue::~DispatchQueue()
+{
+  // anything enqueue()d while stopping is dropped
+  for (auto p = staged.exchange(nullptr); p; ) {
+    delete std::exchange(p, p->next);
+  }
+  ceph_assert(mqueue.empty());
+  ceph_assert(marrival.empty());
+  ceph_assert(local_messages.empty());
+  cct->get_perfcounters_collection()->remove(logger);
+  delete logger;
+}
+
 double DispatchQueue::get_max_age(utime_t now) const {
   std::lock_guard l{lock};
   if (marrival.empty())
@@ -38,8 +126,13 @@ double DispatchQueue::get_max_age(utime_t now) const {
     return (now - marrival.begin()->first);
 }
 
-uint64_t DispatchQueue::pre_dispatch(const ref_t<Message>& m)
+uint64_t DispatchQueue::pre_dispatch(const ref_t<Message>& m, int counter)
 {
+  auto lat = ceph_clock_now() - m->get_recv_complete_stamp();
+  logger->inc(counter);
+  logger->tinc(l_dispatch_queue_lat, lat);
+  logger->hinc(l_dispatch_queue_lat_histogram, lat.to_nsec(),
+	       prio_band(m->get_priority()));
   ldout(cct,1) << "<== " << m->get_source_inst()
 	       << " " << m->get_seq()
 	       << " ==== " << *m
@@ -70,7 +163,7 @@ bool DispatchQueue::can_fast_dispatch(const cref_t<Message> &m) const
 
 void DispatchQueue::fast_dispatch(const ref_t<Message>& m)
 {
-  uint64_t msize = pre_dispatch(m);
+  uint64_t msize = pre_dispatch(m, l_dispatch_queue_fast_dispatch);
   msgr->ms_fast_dispatch(m);
   post_dispatch(m, msize);
 }
@@ -82,18 +175,84 @@ void DispatchQueue::fast_preprocess(const ref_t<Message>& m)
 
 void DispatchQueue::enqueue(const ref_t<Message>& m, int priority, uint64_t id)
 {
-  std::lock_guard l{lock};
   if (stop) {
     return;
   }
   ldout(cct,20) << "queue " << m << " prio " << priority << dendl;
-  add_arrival(m);
-  if (priority >= CEPH_MSG_PRIO_LOW) {
-    mqueue.enqueue_strict(id, priority, QueueItem(m));
-  } else {
-    mqueue.enqueue(id, priority, m->get_cost(), QueueItem(m));
+  auto item = new staged_item_t{nullptr, m, priority, id};
+  ++num_staged;
+  auto head = staged.load(std::memory_order_relaxed);
+  do {
+    item->next = head;
+  } while (!staged.compare_exchange_weak(head, item,
+					 std::memory_order_release,
+					 std::memory_order_relaxed));
+  if (!head) {
+    // whoever drained the list last may be waiting for more
+    std::lock_guard l{lock};
+    cond.notify_all();
   }
-  cond.notify_all();
+}
+
+// must be called with `lock` held
+void DispatchQueue::drain_staged()
+{
+  auto head = staged.exchange(nullptr, std::memory_order_acquire);
+  if (!head) {
+    return;
+  }
+  // restore the arrival order
+  staged_item_t *p = nullptr;
+  while (head) {
+    auto next = head->next;
+    head->next = p;
+    p = head;
+    head = next;
+  }
+  while (p) {
+    std::unique_ptr<staged_item_t> item{std::exchange(p, p->next)};
+    --num_staged;
+    if (stop) {
+      continue;
+    }
+    add_arrival(item->m);
+    if (item->priority >= CEPH_MSG_PRIO_LOW) {
+      mqueue.enqueue_strict(item->id, item->priority,
+			    QueueItem(std::move(item->m)));
+    } else {
+      auto cost = item->m->get_cost();
+      mqueue.enqueue(item->id, item->priority, cost,
+		     QueueItem(std::move(item->m)));
+    }
+  }
+}
+
+std::unique_lock<ceph::mutex> DispatchQueue::try_begin_dispatch_inline(
+  const cref_t<Message>& m)
+{
+  if (inline_types.empty() || !inline_types.count(m->get_type())) {
+    return {};
+  }
+  std::unique_lock dl{dispatch_lock, std::try_to_lock};
+  if (!dl) {
+    return {};
+  }
+  std::lock_guard l{lock};
+  drain_staged();
+  if (stop || !mqueue.empty()) {
+    return {};
+  }
+  return dl;
+}
+
+void DispatchQueue::dispatch_inline(const ref_t<Message>& m,
+				    std::unique_lock<ceph::mutex>&& dl)
+{
+  ceph_assert(dl.owns_lock() && dl.mutex() == &dispatch_lock);
+  uint64_t msize = pre_dispatch(m, l_dispatch_queue_inline_dispatch);
+  msgr->ms_deliver_dispatch(m);
+  post_dispatch(m, msize);
+  dl.unlock();
 }
 
 void DispatchQueue::local_delivery(const ref_t<Message>& m, int priority)
@@ -155,8 +314,10 @@ void DispatchQueue::dispatch_throttle_release(uint64_t msize)
  */
 void DispatchQueue::entry()
 {
+  std::unique_lock dl{dispatch_lock};
   std::unique_lock l{lock};
   while (true) {
+    drain_staged();
     while (!mqueue.empty()) {
       QueueItem qitem = mqueue.dequeue();
       if (!qitem.is_code())
@@ -197,24 +358,31 @@ void DispatchQueue::entry()
 	if (stop) {
 	  ldout(cct,10) << " stop flag set, discarding " << m << " " << *m << dendl;
 	} else {
-	  uint64_t msize = pre_dispatch(m);
+	  uint64_t msize = pre_dispatch(m, l_dispatch_queue_queued_dispatch);
 	  msgr->ms_deliver_dispatch(m);
 	  post_dispatch(m, msize);
 	}
       }
 
       l.lock();
+      drain_staged();
     }
     if (stop)
       break;
 
-    // wait for something to be put on queue
+    // wait for something to be put on queue; meanwhile the workers may
+    // dispatch inline
+    dl.unlock();
     cond.wait(l);
+    l.unlock();
+    dl.lock();
+    l.lock();
   }
 }
 
 void DispatchQueue::discard_queue(uint64_t id) {
   std::lock_guard l{lock};
+  drain_staged();
   std::list<QueueItem> removed;
   mqueue.remove_by_class(id, &removed);
   for (auto i = removed.begin(); i != removed.end(); ++i) {
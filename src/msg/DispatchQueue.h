@@ -18,6 +18,7 @@
 #include <atomic>
 #include <map>
 #include <queue>
+#include <set>
 #include <boost/intrusive_ptr.hpp>
 #include "include/ceph_assert.h"
 #include "include/common_fwd.h"
@@ -25,17 +26,34 @@
 #include "common/ceph_mutex.h"
 #include "common/Thread.h"
 #include "common/PrioritizedQueue.h"
+#include "common/perf_counters.h"
 
 #include "Message.h"
 
 class Messenger;
 struct Connection;
 
+enum {
+  l_dispatch_queue_first = 93000,
+  l_dispatch_queue_fast_dispatch,
+  l_dispatch_queue_inline_dispatch,
+  l_dispatch_queue_queued_dispatch,
+  l_dispatch_queue_lat,
+  l_dispatch_queue_lat_histogram,
+  l_dispatch_queue_last,
+};
+
 /**
  * The DispatchQueue contains all the connections which have Messages
  * they want to be dispatched, carefully organized by Message priority
  * and permitted to deliver in a round-robin fashion.
  * See Messenger::dispatch_entry for details.
+ *
+ * Messages are handed over by the worker threads through a lock-free
+ * list, which is moved into the PrioritizedQueue by whoever holds
+ * `lock` next -- usually the dispatch thread.  So receiving a message
+ * takes `lock` only to wake up the dispatch thread when it may be
+ * idle.
  */
 class DispatchQueue {
   class QueueItem {
@@ -69,6 +87,25 @@ class DispatchQueue {
 
   PrioritizedQueue<QueueItem, uint64_t> mqueue;
 
+  // messages enqueue()d but not yet moved into mqueue, newest first
+  struct staged_item_t {
+    staged_item_t *next;
+    ceph::ref_t<Message> m;
+    int priority;
+    uint64_t id;
+  };
+  std::atomic<staged_item_t*> staged{nullptr};
+  std::atomic<int> num_staged{0};
+  void drain_staged();
+
+  // Held by whoever is delivering a message through ms_deliver_dispatch():
+  // the dispatch thread while mqueue isn't empty, or a worker thread
+  // dispatching a message of one of inline_types.  Ordered before `lock`.
+  ceph::mutex dispatch_lock;
+  std::set<int> inline_types;
+
+  PerfCounters *logger = nullptr;
+
   std::set<std::pair<double, ceph::ref_t<Message>>> marrival;
   std::map<ceph::ref_t<Message>, decltype(marrival)::iterator> marrival_map;
   void add_arrival(const ceph::ref_t<Message>& m) {
@@ -117,7 +154,7 @@ class DispatchQueue {
     }
   } local_delivery_thread;
 
-  uint64_t pre_dispatch(const ceph::ref_t<Message>& m);
+  uint64_t pre_dispatch(const ceph::ref_t<Message>& m, int counter);
   void post_dispatch(const ceph::ref_t<Message>& m, uint64_t msize);
 
  public:
@@ -125,7 +162,7 @@ class DispatchQueue {
   /// Throttle preventing us from building up a big backlog waiting for dispatch
   Throttle dispatch_throttler;
 
-  bool stop;
+  std::atomic<bool> stop;
   void local_delivery(const ceph::ref_t<Message>& m, int priority);
   void local_delivery(Message* m, int priority) {
     return local_delivery(ceph::ref_t<Message>(m, false), priority); /* consume ref */
@@ -136,7 +173,7 @@ class DispatchQueue {
 
   int get_queue_len() const {
     std::lock_guard l{lock};
-    return mqueue.length();
+    return mqueue.length() + num_staged;
   }
 
   /**
@@ -150,6 +187,7 @@ class DispatchQueue {
     std::lock_guard l{lock};
     if (stop)
       return;
+    drain_staged();
     mqueue.enqueue_strict(
       0,
       CEPH_MSG_PRIO_HIGHEST,
@@ -160,6 +198,7 @@ class DispatchQueue {
     std::lock_guard l{lock};
     if (stop)
       return;
+    drain_staged();
     mqueue.enqueue_strict(
       0,
       CEPH_MSG_PRIO_HIGHEST,
@@ -170,6 +209,7 @@ class DispatchQueue {
     std::lock_guard l{lock};
     if (stop)
       return;
+    drain_staged();
     mqueue.enqueue_strict(
       0,
       CEPH_MSG_PRIO_HIGHEST,
@@ -180,6 +220,7 @@ class DispatchQueue {
     std::lock_guard l{lock};
     if (stop)
       return;
+    drain_staged();
     mqueue.enqueue_strict(
       0,
       CEPH_MSG_PRIO_HIGHEST,
@@ -190,6 +231,7 @@ class DispatchQueue {
     std::lock_guard l{lock};
     if (stop)
       return;
+    drain_staged();
     mqueue.enqueue_strict(
       0,
       CEPH_MSG_PRIO_HIGHEST,
@@ -207,6 +249,26 @@ class DispatchQueue {
   void enqueue(Message* m, int priority, uint64_t id) {
     return enqueue(ceph::ref_t<Message>(m, false), priority, id); /* consume ref */
   }
+
+  /**
+   * Let the calling thread dispatch m itself, instead of queueing it.
+   *
+   * This is allowed for the message types listed in
+   * ms_dispatch_inline_types, and only while the dispatch thread is
+   * idle with nothing queued, so ms_dispatch() calls remain serialized
+   * and ordered with the messages queued before.  On success returns
+   * the lock to be passed to dispatch_inline(); the caller should drop
+   * its own locks in between, as it would for fast_dispatch().
+   */
+  std::unique_lock<ceph::mutex> try_begin_dispatch_inline(
+    const ceph::cref_t<Message>& m);
+  void dispatch_inline(const ceph::ref_t<Message>& m,
+		       std::unique_lock<ceph::mutex>&& dl);
+  void dispatch_inline(Message* m, std::unique_lock<ceph::mutex>&& dl) {
+    return dispatch_inline(ceph::ref_t<Message>(m, false), /* consume ref */
+			   std::move(dl));
+  }
+
   void discard_queue(uint64_t id);
   void discard_local();
   uint64_t get_id() {
@@ -218,25 +280,8 @@ class DispatchQueue {
   void shutdown();
   bool is_started() const {return dispatch_thread.is_started();}
 
-  DispatchQueue(CephContext *cct, Messenger *msgr, std::string &name)
-    : cct(cct), msgr(msgr),
-      lock(ceph::make_mutex("Messenger::DispatchQueue::lock" + name)),
-      mqueue(cct->_conf->ms_pq_max_tokens_per_priority,
-	     cct->_conf->ms_pq_min_cost),
-      next_id(1),
-      dispatch_thread(this),
-      local_delivery_lock(ceph::make_mutex("Messenger::DispatchQueue::local_delivery_lock" + name)),
-      stop_local_delivery(false),
-      local_delivery_thread(this),
-      dispatch_throttler(cct, std::string("msgr_dispatch_throttler-") + name,
-                         cct->_conf->ms_dispatch_throttle_bytes),
-      stop(false)
-    {}
-  ~DispatchQueue() {
-    ceph_assert(mqueue.empty());
-    ceph_assert(marrival.empty());
-    ceph_assert(local_messages.empty());
-  }
+  DispatchQueue(CephContext *cct, Messenger *msgr, std::string &name);
+  ~DispatchQueue();
 };
 
 #endif
@@ -128,6 +128,26 @@ public:
     return false;
   }
 
+  /**
+   * Supply the buffer the data payload of an incoming message is read
+   * into, if you support fast dispatch. This is called from the
+   * Messenger's thread once the message header is known and before the
+   * payload comes off the wire, so a Dispatcher can place the payload
+   * where its consumer wants it instead of copying it there later. The
+   * header has not been integrity checked yet.
+   *
+   * @param con The Connection the message is arriving on.
+   * @param type The message type.
+   * @param data_off The sender's data_off hint.
+   * @param len The number of bytes that will be read.
+   * @param bp Set to a buffer of exactly len bytes if returning true.
+   * @return true if bp was set, false to let the Messenger allocate.
+   */
+  virtual bool ms_alloc_rx_data(Connection *con, int type, unsigned data_off,
+				unsigned len, ceph::buffer::ptr *bp) {
+    return false;
+  }
+
   /**
    * This function will be called whenever a Connection is newly-created
    * or reconnects in the Messenger.
@@ -710,6 +710,25 @@ public:
   void ms_deliver_dispatch(Message *m) {
     return ms_deliver_dispatch(ceph::ref_t<Message>(m, false)); /* consume ref */
   }
+  /**
+   * Ask the fast Dispatchers for the buffer an incoming message's data
+   * payload should be read into.
+   *
+   * @param con The Connection the message is arriving on.
+   * @param type The message type.
+   * @param data_off The sender's data_off hint.
+   * @param len The number of bytes that will be read.
+   * @param bp Set to the buffer to use if returning true.
+   * @return true if a Dispatcher supplied the buffer.
+   */
+  bool ms_deliver_alloc_rx_data(Connection *con, int type, unsigned data_off,
+				unsigned len, ceph::buffer::ptr *bp) {
+    for (const auto &dispatcher : fast_dispatchers) {
+      if (dispatcher->ms_alloc_rx_data(con, type, data_off, len, bp))
+	return true;
+    }
+    return false;
+  }
   /**
    * Notify each Dispatcher of a new Connection. Call
    * this function whenever a new Connection is initiated or
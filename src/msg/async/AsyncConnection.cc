@@ -123,6 +123,10 @@ AsyncConnection::AsyncConnection(CephContext *cct, AsyncMessenger *m, DispatchQu
     last_active(ceph::coarse_mono_clock::now()),
     connect_timeout_us(cct->_conf->ms_connection_ready_timeout*1000*1000),
     inactive_timeout_us(cct->_conf->ms_connection_idle_timeout*1000*1000),
+    write_coalesce_bytes(
+      cct->_conf.get_val<Option::size_t>("ms_async_write_coalesce_bytes")),
+    write_coalesce_time(std::chrono::microseconds(
+      cct->_conf.get_val<uint64_t>("ms_async_write_coalesce_time_us"))),
     msgr2(m2), state_offset(0),
     worker(w), center(&w->center),read_buffer(nullptr)
 {
@@ -134,8 +138,6 @@ AsyncConnection::AsyncConnection(CephContext *cct, AsyncMessenger *m, DispatchQu
   write_callback_handler = new C_handle_write_callback(this);
   wakeup_handler = new C_time_wakeup(this);
   tick_handler = new C_tick_wakeup(this);
-  // double recv_max_prefetch see "read_until"
-  recv_buf = new char[2*recv_max_prefetch];
   if (local) {
     protocol = std::unique_ptr<Protocol>(new LoopbackProtocolV1(this));
   } else if (m2) {
@@ -148,8 +150,11 @@ AsyncConnection::AsyncConnection(CephContext *cct, AsyncMessenger *m, DispatchQu
 
 AsyncConnection::~AsyncConnection()
 {
-  if (recv_buf)
+  if (recv_buf) {
+    // not necessarily in the worker's thread, so don't touch its pool
+    logger->dec(l_msgr_recv_prefetch_bufs);
     delete[] recv_buf;
+  }
   ceph_assert(!delay_state);
 }
 
@@ -199,7 +204,8 @@ ssize_t AsyncConnection::read(unsigned len, char *buffer,
 // Normally, only "read_message" will pass existing bufferptr in
 //
 // And it will uses readahead method to reduce small read overhead,
-// "recv_buf" is used to store read buffer
+// "recv_buf" is used to store read buffer.  It is borrowed from the
+// worker for as long as it holds unconsumed data.
 //
 // return the remaining bytes, 0 means this buffer is finished
 // else return < 0 means error
@@ -226,6 +232,9 @@ ssize_t AsyncConnection::read_until(unsigned len, char *p)
                                << " left is " << left << " buffer still has "
                                << recv_end - recv_start << dendl;
     if (left == 0) {
+      if (recv_start == recv_end) {
+        put_recv_buf();
+      }
       return 0;
     }
     state_offset += to_read;
@@ -234,6 +243,7 @@ ssize_t AsyncConnection::read_until(unsigned len, char *p)
   recv_end = recv_start = 0;
   /* nothing left in the prefetch buffer */
   if (left > (uint64_t)recv_max_prefetch) {
+    put_recv_buf();
     /* this was a large read, we don't prefetch for these */
     do {
       r = read_bulk(p+state_offset, left);
@@ -249,12 +259,17 @@ ssize_t AsyncConnection::read_until(unsigned len, char *p)
       left -= r;
     } while (r > 0);
   } else {
+    if (!recv_buf) {
+      // double recv_max_prefetch see below
+      recv_buf = worker->get_recv_buf(2*recv_max_prefetch);
+    }
     do {
       r = read_bulk(recv_buf+recv_end, recv_max_prefetch);
       ldout(async_msgr->cct, 25) << __func__ << " read_bulk recv_end is " << recv_end
                                  << " left is " << left << " got " << r << dendl;
       if (r < 0) {
         ldout(async_msgr->cct, 1) << __func__ << " read failed" << dendl;
+        put_recv_buf();
         return -1;
       }
       recv_end += r;
@@ -262,6 +277,10 @@ ssize_t AsyncConnection::read_until(unsigned len, char *p)
         recv_start = len - state_offset;
         memcpy(p+state_offset, recv_buf, recv_start);
         state_offset = 0;
+        if (recv_start == recv_end) {
+          recv_end = recv_start = 0;
+          put_recv_buf();
+        }
         return 0;
       }
       left -= r;
@@ -269,12 +288,21 @@ ssize_t AsyncConnection::read_until(unsigned len, char *p)
     memcpy(p+state_offset, recv_buf, recv_end-recv_start);
     state_offset += (recv_end - recv_start);
     recv_end = recv_start = 0;
+    put_recv_buf();
   }
   ldout(async_msgr->cct, 25) << __func__ << " need len " << len << " remaining "
                              << len - state_offset << " bytes" << dendl;
   return len - state_offset;
 }
 
+void AsyncConnection::put_recv_buf()
+{
+  if (recv_buf) {
+    worker->put_recv_buf(recv_buf, 2*recv_max_prefetch);
+    recv_buf = nullptr;
+  }
+}
+
 /* return -1 means `fd` occurs error or closed, it should be closed
  * return 0 means EAGAIN or EINTR */
 ssize_t AsyncConnection::read_bulk(char *buf, unsigned len)
@@ -336,6 +364,13 @@ ssize_t AsyncConnection::_try_send(bool more)
   ldout(async_msgr->cct, 10) << __func__ << " sent bytes " << r
                              << " remaining bytes " << outgoing_bl.length() << dendl;
 
+  if (unsent_frames) {
+    logger->inc(l_msgr_send_frames_per_write, unsent_frames);
+    frames_sent += unsent_frames;
+    frame_writes++;
+    unsent_frames = 0;
+  }
+
   if (!open_write && is_queued()) {
     center->create_file_event(cs.fd(), EVENT_WRITABLE, write_handler);
     open_write = true;
@@ -352,6 +387,22 @@ ssize_t AsyncConnection::_try_send(bool more)
   return outgoing_bl.length();
 }
 
+void AsyncConnection::frame_appended()
+{
+  if (unsent_frames++ == 0 && write_coalesce_bytes) {
+    unsent_since = ceph::mono_clock::now();
+  }
+}
+
+// May the frames appended so far wait for the ones of the messages
+// queued behind them (if `more`) instead of being sent right away?
+bool AsyncConnection::can_defer_send(bool more) const
+{
+  return more && write_coalesce_bytes &&
+    outgoing_bl.length() < write_coalesce_bytes &&
+    ceph::mono_clock::now() - unsent_since < write_coalesce_time;
+}
+
 void AsyncConnection::inject_delay() {
   if (async_msgr->cct->_conf->ms_inject_internal_delays) {
     ldout(async_msgr->cct, 10) << __func__ << " sleep for " <<
@@ -448,6 +499,9 @@ void AsyncConnection::process() {
     }
 
     case STATE_CONNECTION_ESTABLISHED: {
+      // the protocol may not read now (e.g. while throttled), which
+      // must not leave the socket readable for ever
+      cs.drain_error_queue();
       if (pendingReadLen) {
         ssize_t r = read(*pendingReadLen, read_buffer, readCallback);
         if (r <= 0) { // read all bytes, or an error occured
@@ -597,9 +651,13 @@ void AsyncConnection::fault()
   recv_start = recv_end = 0;
   state_offset = 0;
   outgoing_bl.clear();
+  unsent_frames = 0;
 }
 
 void AsyncConnection::_stop() {
+  ldout(async_msgr->cct, 5) << __func__ << " sent " << frames_sent
+                            << " frames in " << frame_writes << " writes"
+                            << dendl;
   writeCallback.reset();
   dispatch_queue->discard_queue(conn_id);
   async_msgr->unregister_conn(this);
@@ -735,6 +793,7 @@ void AsyncConnection::stop(bool queue_reset) {
 
 void AsyncConnection::cleanup() {
   shutdown_socket();
+  put_recv_buf();
   delete read_handler;
   delete write_handler;
   delete write_callback_handler;
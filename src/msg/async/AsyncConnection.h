@@ -55,10 +55,13 @@ class AsyncConnection : public Connection {
                std::function<void(char *, ssize_t)> callback);
   ssize_t read_until(unsigned needed, char *p);
   ssize_t read_bulk(char *buf, unsigned len);
+  void put_recv_buf();
 
   ssize_t write(ceph::buffer::list &bl, std::function<void(ssize_t)> callback,
                 bool more=false);
   ssize_t _try_send(bool more=false);
+  void frame_appended();
+  bool can_defer_send(bool more) const;
 
   void _connect();
   void _stop();
@@ -185,6 +188,17 @@ private:
   ceph::buffer::list outgoing_bl;
   bool open_write = false;
 
+  // Frames appended to outgoing_bl but not sent yet.  When more
+  // messages are queued, their frames are gathered into one write of
+  // up to ms_async_write_coalesce_bytes, for at most
+  // ms_async_write_coalesce_time.
+  const uint64_t write_coalesce_bytes;
+  const ceph::timespan write_coalesce_time;
+  unsigned unsent_frames = 0;
+  ceph::mono_clock::time_point unsent_since;
+  uint64_t frames_sent = 0;
+  uint64_t frame_writes = 0;
+
   std::mutex write_lock;
 
   std::mutex lock;
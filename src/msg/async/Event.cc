@@ -21,6 +21,9 @@
 #ifdef HAVE_DPDK
 #include "dpdk/EventDPDK.h"
 #endif
+#ifdef HAVE_ASYNC_URING
+#include "uring/EventUring.h"
+#endif
 
 #ifdef HAVE_EPOLL
 #include "EventEpoll.h"
@@ -111,6 +114,10 @@ int EventCenter::init(int nevent, unsigned center_id, const std::string &type)
   if (type == "dpdk") {
 #ifdef HAVE_DPDK
     driver = new DPDKDriver(cct);
+#endif
+  } else if (type == "uring") {
+#ifdef HAVE_ASYNC_URING
+    driver = new UringDriver(cct);
 #endif
   } else {
 #ifdef HAVE_EPOLL
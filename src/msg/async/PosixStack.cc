@@ -19,8 +19,13 @@
 #include <netinet/in.h>
 #include <arpa/inet.h>
 #include <errno.h>
+#if defined(__linux__) && defined(SO_ZEROCOPY) && defined(MSG_ZEROCOPY)
+#include <linux/errqueue.h>
+#define HAVE_MSG_ZEROCOPY
+#endif
 
 #include <algorithm>
+#include <deque>
 
 #include "PosixStack.h"
 
@@ -29,6 +34,7 @@
 #include "common/errno.h"
 #include "common/strtol.h"
 #include "common/dout.h"
+#include "common/perf_counters.h"
 #include "msg/Messenger.h"
 #include "include/compat.h"
 #include "include/sock_compat.h"
@@ -42,11 +48,86 @@ class PosixConnectedSocketImpl final : public ConnectedSocketImpl {
   int _fd;
   entity_addr_t sa;
   bool connected;
+  PerfCounters *logger;
+
+  // sendmsg calls of at least this many bytes use MSG_ZEROCOPY; 0 if off
+  uint64_t zerocopy_min_size;
+#ifdef HAVE_MSG_ZEROCOPY
+  // the kernel numbers zerocopy sends consecutively per socket and later
+  // reports ranges of them as done; until then it may still read the
+  // pages, so we keep a reference to what each one sent.  one send() may
+  // take several sendmsg calls, so an entry covers the ids [first, last]
+  // and is released once every one of them has completed.
+  struct zerocopy_send_t {
+    uint32_t first;
+    uint32_t last;
+    uint32_t completed = 0;
+    ceph::buffer::list bl;
+    zerocopy_send_t(uint32_t first, uint32_t last, ceph::buffer::list&& bl)
+      : first(first), last(last), bl(std::move(bl)) {}
+    bool done() const {
+      return completed == last - first + 1;
+    }
+    // count the ids of [lo, hi] that fall in [first, last]
+    void complete(uint32_t lo, uint32_t hi) {
+      int64_t from = std::max<int64_t>(0, (int32_t)(lo - first));
+      int64_t to = std::min<int64_t>(last - first, (int32_t)(hi - first));
+      if (to >= from) {
+	completed += to - from + 1;
+      }
+    }
+  };
+  std::deque<zerocopy_send_t> zerocopy_pending;
+  uint32_t zerocopy_next_id = 0;
+
+  void reap_zerocopy() {
+    while (!zerocopy_pending.empty()) {
+      char control[CMSG_SPACE(sizeof(struct sock_extended_err)) + 64];
+      struct msghdr msg;
+      // FIPS zeroization audit 20191115: this memset is not security related.
+      memset(&msg, 0, sizeof(msg));
+      msg.msg_control = control;
+      msg.msg_controllen = sizeof(control);
+      if (::recvmsg(_fd, &msg, MSG_ERRQUEUE | MSG_DONTWAIT) < 0) {
+	break;
+      }
+      for (auto cmsg = CMSG_FIRSTHDR(&msg); cmsg;
+	   cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+	if (!((cmsg->cmsg_level == SOL_IP && cmsg->cmsg_type == IP_RECVERR) ||
+	      (cmsg->cmsg_level == SOL_IPV6 &&
+	       cmsg->cmsg_type == IPV6_RECVERR))) {
+	  continue;
+	}
+	auto serr = reinterpret_cast<struct sock_extended_err*>(
+	  CMSG_DATA(cmsg));
+	if (serr->ee_origin != SO_EE_ORIGIN_ZEROCOPY || serr->ee_errno != 0) {
+	  continue;
+	}
+	uint32_t lo = serr->ee_info, hi = serr->ee_data;
+	if (serr->ee_code & SO_EE_CODE_ZEROCOPY_COPIED) {
+	  // e.g. loopback, or a NIC without scatter-gather: we pay for
+	  // the notifications and get a copy anyway
+	  logger->inc(l_msgr_send_zerocopy_copied);
+	  zerocopy_min_size = 0;
+	}
+	// ranges usually complete in order, but not always
+	for (auto& z : zerocopy_pending) {
+	  z.complete(lo, hi);
+	}
+      }
+      while (!zerocopy_pending.empty() && zerocopy_pending.front().done()) {
+	zerocopy_pending.pop_front();
+      }
+    }
+  }
+#endif
 
  public:
   explicit PosixConnectedSocketImpl(ceph::NetHandler &h, const entity_addr_t &sa,
-				    int f, bool connected)
-      : handler(h), _fd(f), sa(sa), connected(connected) {}
+				    int f, bool connected, PerfCounters *logger,
+				    uint64_t zerocopy_min_size)
+      : handler(h), _fd(f), sa(sa), connected(connected), logger(logger),
+	zerocopy_min_size(zerocopy_min_size) {}
 
   int is_connected() override {
     if (connected)
@@ -64,30 +145,59 @@ class PosixConnectedSocketImpl final : public ConnectedSocketImpl {
   }
 
   ssize_t read(char *buf, size_t len) override {
+#ifdef HAVE_MSG_ZEROCOPY
+    reap_zerocopy();
+#endif
     ssize_t r = ::read(_fd, buf, len);
     if (r < 0)
       r = -errno;
     return r;
   }
 
+  void drain_error_queue() override {
+#ifdef HAVE_MSG_ZEROCOPY
+    // zerocopy completions wake us up as EPOLLERR, which is reported as
+    // readable until they are consumed
+    reap_zerocopy();
+#endif
+  }
+
   // return the sent length
   // < 0 means error occurred
   #ifndef _WIN32
-  static ssize_t do_sendmsg(int fd, struct msghdr &msg, unsigned len, bool more)
+  //
+  // with zerocopy set, MSG_ZEROCOPY is requested and *zerocopy_sends
+  // counts the calls that sent something with it
+  static ssize_t do_sendmsg(int fd, struct msghdr &msg, unsigned len, bool more,
+			    bool zerocopy = false,
+			    unsigned *zerocopy_sends = nullptr)
   {
     size_t sent = 0;
     while (1) {
       MSGR_SIGPIPE_STOPPER;
       ssize_t r;
-      r = ::sendmsg(fd, &msg, MSG_NOSIGNAL | (more ? MSG_MORE : 0));
+      int flags = MSG_NOSIGNAL | (more ? MSG_MORE : 0);
+#ifdef HAVE_MSG_ZEROCOPY
+      if (zerocopy) {
+	flags |= MSG_ZEROCOPY;
+      }
+#endif
+      r = ::sendmsg(fd, &msg, flags);
       if (r < 0) {
         if (errno == EINTR) {
           continue;
         } else if (errno == EAGAIN) {
           break;
+        } else if (errno == ENOBUFS && zerocopy) {
+          // over the optmem limit for outstanding notifications
+          zerocopy = false;
+          continue;
         }
         return -errno;
       }
+      if (zerocopy && r > 0) {
+        ++*zerocopy_sends;
+      }
 
       sent += r;
       if (len == sent) break;
@@ -109,6 +219,9 @@ class PosixConnectedSocketImpl final : public ConnectedSocketImpl {
   }
 
   ssize_t send(ceph::buffer::list &bl, bool more) override {
+#ifdef HAVE_MSG_ZEROCOPY
+    reap_zerocopy();
+#endif
     size_t sent_bytes = 0;
     auto pb = std::cbegin(bl.buffers());
     uint64_t left_pbrs = bl.get_num_buffers();
@@ -128,9 +241,24 @@ class PosixConnectedSocketImpl final : public ConnectedSocketImpl {
 	msglen += pb->length();
 	++pb;
       }
-      ssize_t r = do_sendmsg(_fd, msg, msglen, left_pbrs || more);
+      bool zerocopy = zerocopy_min_size && msglen >= zerocopy_min_size;
+      unsigned zerocopy_sends = 0;
+      ssize_t r = do_sendmsg(_fd, msg, msglen, left_pbrs || more,
+			     zerocopy, &zerocopy_sends);
       if (r < 0)
         return r;
+#ifdef HAVE_MSG_ZEROCOPY
+      if (zerocopy_sends) {
+	// pin what we just handed over until the kernel is done with it
+	ceph::buffer::list held;
+	held.substr_of(bl, sent_bytes, r);
+	zerocopy_pending.emplace_back(zerocopy_next_id,
+				      zerocopy_next_id + zerocopy_sends - 1,
+				      std::move(held));
+	zerocopy_next_id += zerocopy_sends;
+	logger->inc(l_msgr_send_zerocopy_bytes, r);
+      }
+#endif
 
       // "r" is the remaining length
       sent_bytes += r;
@@ -200,6 +328,9 @@ class PosixConnectedSocketImpl final : public ConnectedSocketImpl {
   }
   void close() override {
     ::close(_fd);
+#ifdef HAVE_MSG_ZEROCOPY
+    zerocopy_pending.clear();
+#endif
   }
   int fd() const override {
     return _fd;
@@ -254,7 +385,14 @@ int PosixServerSocketImpl::accept(ConnectedSocket *sock, const SocketOptions &op
   out->set_sockaddr((sockaddr*)&ss);
   handler.set_priority(sd, opt.priority, out->get_family());
 
-  std::unique_ptr<PosixConnectedSocketImpl> csi(new PosixConnectedSocketImpl(handler, *out, sd, true));
+  uint64_t zerocopy_min_size =
+    w->cct->_conf.get_val<Option::size_t>("ms_tcp_zerocopy_min_size");
+  if (zerocopy_min_size && !handler.set_zerocopy(sd)) {
+    zerocopy_min_size = 0;
+  }
+  std::unique_ptr<PosixConnectedSocketImpl> csi(
+    new PosixConnectedSocketImpl(handler, *out, sd, true, w->perf_logger,
+				 zerocopy_min_size));
   *sock = ConnectedSocket(std::move(csi));
   return 0;
 }
@@ -322,8 +460,15 @@ int PosixWorker::connect(const entity_addr_t &addr, const SocketOptions &opts, C
   }
 
   net.set_priority(sd, opts.priority, addr.get_family());
+  uint64_t zerocopy_min_size =
+    cct->_conf.get_val<Option::size_t>("ms_tcp_zerocopy_min_size");
+  if (zerocopy_min_size && !net.set_zerocopy(sd)) {
+    zerocopy_min_size = 0;
+  }
   *socket = ConnectedSocket(
-      std::unique_ptr<PosixConnectedSocketImpl>(new PosixConnectedSocketImpl(net, addr, sd, !opts.nonblock)));
+      std::unique_ptr<PosixConnectedSocketImpl>(
+	new PosixConnectedSocketImpl(net, addr, sd, !opts.nonblock,
+				     perf_logger, zerocopy_min_size)));
   return 0;
 }
 
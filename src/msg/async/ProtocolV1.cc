@@ -825,9 +825,17 @@ CtPtr ProtocolV1::read_message_data_prepare() {
       data_blp = data_buf.begin();
     }
 #else
-    ldout(cct, 20) << __func__ << " allocating new rx buffer at offset "
-		   << data_off << dendl;
-    alloc_aligned_buffer(data_buf, data_len, data_off);
+    ceph::bufferptr bp;
+    if (messenger->ms_deliver_alloc_rx_data(connection, current_header.type,
+					    data_off, data_len, &bp)) {
+      ceph_assert(bp.length() == data_len);
+      ldout(cct, 20) << __func__ << " dispatcher supplied rx buffer" << dendl;
+      data_buf.push_back(std::move(bp));
+    } else {
+      ldout(cct, 20) << __func__ << " allocating new rx buffer at offset "
+		     << data_off << dendl;
+      alloc_aligned_buffer(data_buf, data_len, data_off);
+    }
     data_blp = data_buf.begin();
 #endif
   }
@@ -1039,6 +1047,13 @@ CtPtr ProtocolV1::handle_message_footer(char *buffer, int r) {
     connection->logger->tinc(l_msgr_running_fast_dispatch_time,
                              connection->recv_start_time - fast_dispatch_time);
     connection->lock.lock();
+  } else if (auto dl =
+	       connection->dispatch_queue->try_begin_dispatch_inline(message);
+	     dl) {
+    connection->lock.unlock();
+    connection->dispatch_queue->dispatch_inline(message, std::move(dl));
+    connection->recv_start_time = ceph::mono_clock::now();
+    connection->lock.lock();
   } else {
     connection->dispatch_queue->enqueue(message, message->get_priority(),
                                         connection->conn_id);
@@ -2382,6 +2397,9 @@ CtPtr ProtocolV1::replace(const AsyncConnectionRef& existing,
             existing->write_lock.unlock();
             if (exproto->state == NONE) {
               existing->shutdown_socket();
+              // give the discarded prefetch buffer back to the worker it
+              // came from, in that worker's thread
+              existing->put_recv_buf();
               existing->cs = std::move(cs);
               existing->worker->references--;
               new_worker->references++;
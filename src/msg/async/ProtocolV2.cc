@@ -229,6 +229,13 @@ uint64_t ProtocolV2::discard_requeued_up_to(uint64_t out_seq, uint64_t seq) {
 void ProtocolV2::reset_security() {
   ldout(cct, 5) << __func__ << dendl;
 
+  account_crypto_time();
+  if (crypto_encrypt_time != ceph::timespan::zero() ||
+      crypto_decrypt_time != ceph::timespan::zero()) {
+    ldout(cct, 5) << __func__ << " crypto time encrypt="
+                  << crypto_encrypt_time << " decrypt="
+                  << crypto_decrypt_time << dendl;
+  }
   auth_meta.reset(new AuthConnectionMeta);
   session_stream_handlers.rx.reset(nullptr);
   session_stream_handlers.tx.reset(nullptr);
@@ -236,6 +243,22 @@ void ProtocolV2::reset_security() {
   pre_auth.txbuf.clear();
 }
 
+// Charge the time spent in the session's ciphers since the last call to
+// this connection and to the worker.  Like the rest of the handlers'
+// use, it must be called from the connection's thread.
+void ProtocolV2::account_crypto_time() {
+  if (session_stream_handlers.tx) {
+    auto t = session_stream_handlers.tx->take_busy_time();
+    crypto_encrypt_time += t;
+    connection->logger->tinc(l_msgr_crypto_encrypt_time, t);
+  }
+  if (session_stream_handlers.rx) {
+    auto t = session_stream_handlers.rx->take_busy_time();
+    crypto_decrypt_time += t;
+    connection->logger->tinc(l_msgr_crypto_decrypt_time, t);
+  }
+}
+
 // it's expected the `write_lock` is held while calling this method.
 void ProtocolV2::reset_recv_state() {
   ldout(cct, 5) << __func__ << dendl;
@@ -550,14 +573,18 @@ ssize_t ProtocolV2::write_message(Message *m, bool more) {
                  << " src=" << entity_name_t(messenger->get_myname())
                  << " off=" << header2.data_off
                  << dendl;
-  ssize_t total_send_size = connection->outgoing_bl.length();
-  ssize_t rc = connection->_try_send(more);
+  if (connection->can_defer_send(more)) {
+    // write_event() sends it along with the following messages
+    ldout(cct, 20) << __func__ << " deferring send of m=" << m << dendl;
+    m->put();
+    return 0;
+  }
+
+  ssize_t rc = send_outgoing(more);
   if (rc < 0) {
     ldout(cct, 1) << __func__ << " error sending " << m << ", "
                   << cpp_strerror(rc) << dendl;
   } else {
-    connection->logger->inc(
-        l_msgr_send_bytes, total_send_size - connection->outgoing_bl.length());
     ldout(cct, 10) << __func__ << " sending " << m
                    << (rc ? " continuely." : " done.") << dendl;
   }
@@ -573,6 +600,18 @@ ssize_t ProtocolV2::write_message(Message *m, bool more) {
   return rc;
 }
 
+// _try_send(), accounting what it sent in l_msgr_send_bytes; that
+// includes the frames of earlier messages whose send was deferred
+ssize_t ProtocolV2::send_outgoing(bool more) {
+  ssize_t total_send_size = connection->outgoing_bl.length();
+  ssize_t rc = connection->_try_send(more);
+  if (rc >= 0) {
+    connection->logger->inc(
+        l_msgr_send_bytes, total_send_size - connection->outgoing_bl.length());
+  }
+  return rc;
+}
+
 template <class F>
 bool ProtocolV2::append_frame(F& frame) {
   ceph::bufferlist bl;
@@ -586,6 +625,7 @@ bool ProtocolV2::append_frame(F& frame) {
   ldout(cct, 25) << __func__ << " assembled frame " << bl.length()
                  << " bytes " << tx_frame_asm << dendl;
   connection->outgoing_bl.append(bl);
+  connection->frame_appended();
   return true;
 }
 
@@ -689,18 +729,19 @@ void ProtocolV2::write_event() {
         if (append_frame(ack_frame)) {
           ack_left -= left;
           left = ack_left;
-          r = connection->_try_send(left);
+          r = send_outgoing(left);
         } else {
           r = -EILSEQ;
         }
       } else if (is_queued()) {
-        r = connection->_try_send();
+        r = send_outgoing();
       }
     }
     connection->write_lock.unlock();
 
     connection->logger->tinc(l_msgr_running_send_time,
                              ceph::mono_clock::now() - start);
+    account_crypto_time();
     if (r < 0) {
       ldout(cct, 1) << __func__ << " send msg failed" << dendl;
       connection->lock.lock();
@@ -1162,8 +1203,14 @@ CtPtr ProtocolV2::read_frame_segment() {
   rx_buffer_t rx_buffer;
   uint16_t align = rx_frame_asm.get_segment_align(seg_idx);
   try {
-    rx_buffer = ceph::buffer::ptr_node::create(ceph::buffer::create_aligned(
-        onwire_len, align));
+    if (next_tag == Tag::MESSAGE &&
+        seg_idx == SegmentIndex::Msg::DATA) {
+      rx_buffer = ceph::buffer::ptr_node::create(
+          alloc_rx_data_segment(onwire_len));
+    } else {
+      rx_buffer = ceph::buffer::ptr_node::create(ceph::buffer::create_aligned(
+          onwire_len, align));
+    }
   } catch (std::bad_alloc&) {
     // Catching because of potential issues with satisfying alignment.
     ldout(cct, 1) << __func__ << " can't allocate aligned rx_buffer"
@@ -1176,6 +1223,69 @@ CtPtr ProtocolV2::read_frame_segment() {
   return READ_RXBUF(std::move(rx_buffer), handle_read_frame_segment);
 }
 
+// The message header travels in the first segment, so by the time the
+// data segment is about to be read it is usually already in plaintext:
+// as-is in crc mode, and inlined into the (decrypted) preamble in
+// msgr2.1 secure mode.  Only msgr2.0 secure mode has to wait for the
+// epilogue.
+bool ProtocolV2::peek_rx_message_header(ceph_msg_header2 *header) const {
+  const char *p = nullptr;
+  if (!session_stream_handlers.rx) {
+    ceph_assert(!rx_segments_data.empty());
+    const auto& hdrbl = rx_segments_data[SegmentIndex::Msg::HEADER];
+    if (hdrbl.length() >= sizeof(*header) && hdrbl.get_num_buffers() == 1) {
+      p = hdrbl.front().c_str();
+    }
+  } else if (rx_frame_asm.get_is_rev1()) {
+    if (rx_preamble.length() >= FRAME_PREAMBLE_WITH_INLINE_SIZE &&
+        rx_preamble.get_num_buffers() == 1) {
+      p = rx_preamble.front().c_str() + sizeof(preamble_block_t);
+    }
+  }
+  if (!p) {
+    return false;
+  }
+  memcpy(header, p, sizeof(*header));
+  return true;
+}
+
+// Lay out the buffer for a message's data segment.  A Dispatcher gets
+// the first say; otherwise place the payload so that its address
+// matches the sender's data_off hint modulo the page size, the same way
+// ProtocolV1 does.  For writes data_off is the object offset (MOSDOp) or
+// whatever puts the write payload on a page boundary (MOSDRepOp), which
+// lets the ObjectStore submit the payload for direct I/O as-is instead
+// of rebuilding it into aligned memory.
+ceph::bufferptr ProtocolV2::alloc_rx_data_segment(uint32_t onwire_len) {
+  ceph_msg_header2 header;
+  if (!peek_rx_message_header(&header)) {
+    return ceph::buffer::create_aligned(onwire_len,
+                                        segment_t::PAGE_SIZE_ALIGNMENT);
+  }
+
+  ceph::bufferptr bp;
+  if (messenger->ms_deliver_alloc_rx_data(connection, header.type,
+                                          header.data_off, onwire_len, &bp)) {
+    ceph_assert(bp.length() == onwire_len);
+    ldout(cct, 20) << __func__ << " dispatcher supplied " << onwire_len
+                   << " bytes for type " << header.type << dendl;
+    return bp;
+  }
+
+  unsigned head = header.data_off & ~CEPH_PAGE_MASK;
+  if (head == 0) {
+    return ceph::buffer::create_aligned(onwire_len,
+                                        segment_t::PAGE_SIZE_ALIGNMENT);
+  }
+  bp = ceph::buffer::create_aligned(head + onwire_len,
+                                    segment_t::PAGE_SIZE_ALIGNMENT);
+  bp.set_offset(head);
+  bp.set_length(onwire_len);
+  ldout(cct, 20) << __func__ << " " << onwire_len << " bytes at page offset "
+                 << head << dendl;
+  return bp;
+}
+
 CtPtr ProtocolV2::handle_read_frame_segment(rx_buffer_t &&rx_buffer, int r) {
   ldout(cct, 20) << __func__ << " r=" << r << dendl;
 
@@ -1316,6 +1426,7 @@ CtPtr ProtocolV2::_handle_read_frame_epilogue_main() {
     ldout(cct, 1) << __func__ << "bad auth tag" << dendl;
     return _fault();
   }
+  account_crypto_time();
 
   // we do have a mechanism that allows transmitter to start sending message
   // and abort after putting entire data field on wire. This will be used by
@@ -1490,6 +1601,16 @@ CtPtr ProtocolV2::handle_message() {
       // yes, that was the case, let's do nothing
       return nullptr;
     }
+  } else if (auto dl =
+	       connection->dispatch_queue->try_begin_dispatch_inline(message);
+	     dl) {
+    connection->lock.unlock();
+    connection->dispatch_queue->dispatch_inline(message, std::move(dl));
+    connection->recv_start_time = ceph::mono_clock::now();
+    connection->lock.lock();
+    if (state != READY) {
+      return nullptr;
+    }
   } else {
     connection->dispatch_queue->enqueue(message, message->get_priority(),
                                         connection->conn_id);
@@ -2711,6 +2832,9 @@ CtPtr ProtocolV2::reuse_connection(const AsyncConnectionRef& existing,
           existing->write_lock.unlock();
           if (exproto->state == NONE) {
             existing->shutdown_socket();
+            // give the discarded prefetch buffer back to the worker it
+            // came from, in that worker's thread
+            existing->put_recv_buf();
             existing->cs = std::move(cs);
             existing->worker->references--;
             new_worker->references++;
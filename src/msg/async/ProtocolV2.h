@@ -67,6 +67,9 @@ private:
 
   // TODO: move into auth_meta?
   ceph::crypto::onwire::rxtx_t session_stream_handlers;
+  // time spent encrypting and decrypting for this connection
+  ceph::timespan crypto_encrypt_time = ceph::timespan::zero();
+  ceph::timespan crypto_decrypt_time = ceph::timespan::zero();
 
   entity_name_t peer_name;
   State state;
@@ -135,6 +138,7 @@ private:
   uint64_t discard_requeued_up_to(uint64_t out_seq, uint64_t seq);
   void reset_recv_state();
   void reset_security();
+  void account_crypto_time();
   void reset_throttle();
   Ct<ProtocolV2> *_fault();
   void discard_out_queue();
@@ -142,6 +146,7 @@ private:
   void prepare_send_message(uint64_t features, Message *m);
   out_queue_entry_t _get_next_outgoing();
   ssize_t write_message(Message *m, bool more);
+  ssize_t send_outgoing(bool more = false);
   void handle_message_ack(uint64_t seq);
 
   CONTINUATION_DECL(ProtocolV2, _wait_for_peer_banner);
@@ -253,6 +258,8 @@ private:
   Ct<ProtocolV2> *server_ready();
 
   size_t get_current_msg_size() const;
+  bool peek_rx_message_header(ceph_msg_header2 *header) const;
+  ceph::bufferptr alloc_rx_data_segment(uint32_t onwire_len);
 };
 
 #endif /* _MSG_ASYNC_PROTOCOL_V2_ */
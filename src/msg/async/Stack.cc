@@ -26,6 +26,9 @@
 #ifdef HAVE_DPDK
 #include "dpdk/DPDKStack.h"
 #endif
+#ifdef HAVE_ASYNC_URING
+#include "uring/UringStack.h"
+#endif
 
 #include "common/dout.h"
 #include "include/ceph_assert.h"
@@ -76,6 +79,10 @@ std::shared_ptr<NetworkStack> NetworkStack::create(CephContext *c,
   else if (t == "dpdk")
     return std::make_shared<DPDKStack>(c, t);
 #endif
+#ifdef HAVE_ASYNC_URING
+  else if (t == "uring")
+    return std::make_shared<UringNetworkStack>(c, t);
+#endif
 
   lderr(c) << __func__ << " ms_async_transport_type " << t <<
     " is not supported! " << dendl;
@@ -95,6 +102,10 @@ Worker* NetworkStack::create_worker(CephContext *c, const std::string &type, uns
   else if (type == "dpdk")
     return new DPDKWorker(c, worker_id);
 #endif
+#ifdef HAVE_ASYNC_URING
+  else if (type == "uring")
+    return new UringWorker(c, worker_id);
+#endif
 
   lderr(c) << __func__ << " ms_async_transport_type " << type <<
     " is not supported! " << dendl;
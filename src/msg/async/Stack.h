@@ -29,6 +29,7 @@ class ConnectedSocketImpl {
   virtual int is_connected() = 0;
   virtual ssize_t read(char*, size_t) = 0;
   virtual ssize_t send(ceph::buffer::list &bl, bool more) = 0;
+  virtual void drain_error_queue() {}
   virtual void shutdown() = 0;
   virtual void close() = 0;
   virtual int fd() const = 0;
@@ -99,6 +100,14 @@ class ConnectedSocket {
   ssize_t send(ceph::buffer::list &bl, bool more) {
     return _csi->send(bl, more);
   }
+  /// Consumes pending notifications that are not stream data.
+  ///
+  /// Some of them (e.g. MSG_ZEROCOPY completions) keep the socket
+  /// readable until they are consumed, so this must be called whenever
+  /// the socket polls readable, even if no data is read at that time.
+  void drain_error_queue() {
+    _csi->drain_error_queue();
+  }
   /// Disables output to the socket.
   ///
   /// Current or future writes that have not been successfully flushed
@@ -203,6 +212,17 @@ enum {
   l_msgr_send_messages_queue_lat,
   l_msgr_handle_ack_lat,
 
+  l_msgr_send_zerocopy_bytes,
+  l_msgr_send_zerocopy_copied,
+
+  l_msgr_crypto_encrypt_time,
+  l_msgr_crypto_decrypt_time,
+
+  l_msgr_send_frames_per_write,
+
+  l_msgr_recv_prefetch_bufs,
+  l_msgr_recv_prefetch_bufs_allocated,
+
   l_msgr_last,
 };
 
@@ -211,6 +231,11 @@ class Worker {
   std::condition_variable init_cond;
   bool init = false;
 
+  // idle prefetch buffers, see get_recv_buf()
+  static constexpr size_t MAX_FREE_RECV_BUFS = 64;
+  std::vector<std::unique_ptr<char[]>> free_recv_bufs;
+  size_t recv_buf_len = 0;
+
  public:
   bool done = false;
 
@@ -246,6 +271,17 @@ class Worker {
     plb.add_time_avg(l_msgr_send_messages_queue_lat, "msgr_send_messages_queue_lat", "Network sent messages lat");
     plb.add_time_avg(l_msgr_handle_ack_lat, "msgr_handle_ack_lat", "Connection handle ack lat");
 
+    plb.add_u64_counter(l_msgr_send_zerocopy_bytes, "msgr_send_zerocopy_bytes", "Network bytes sent with MSG_ZEROCOPY", NULL, 0, unit_t(UNIT_BYTES));
+    plb.add_u64_counter(l_msgr_send_zerocopy_copied, "msgr_send_zerocopy_copied", "MSG_ZEROCOPY sends the kernel copied anyway");
+
+    plb.add_time(l_msgr_crypto_encrypt_time, "msgr_crypto_encrypt_time", "The total time of encrypting frames in secure mode");
+    plb.add_time(l_msgr_crypto_decrypt_time, "msgr_crypto_decrypt_time", "The total time of decrypting frames in secure mode");
+
+    plb.add_u64_avg(l_msgr_send_frames_per_write, "msgr_send_frames_per_write", "Frames gathered into a single write");
+
+    plb.add_u64(l_msgr_recv_prefetch_bufs, "msgr_recv_prefetch_bufs", "Prefetch buffers lent to connections");
+    plb.add_u64_counter(l_msgr_recv_prefetch_bufs_allocated, "msgr_recv_prefetch_bufs_allocated", "Prefetch buffers allocated");
+
     perf_logger = plb.create_perf_counters();
     cct->get_perfcounters_collection()->add(perf_logger);
   }
@@ -264,6 +300,34 @@ class Worker {
 
   virtual void initialize() {}
   PerfCounters *get_perf_counter() { return perf_logger; }
+
+  // The prefetch buffers of AsyncConnection::read_until() are lent to
+  // a connection only while they hold data it hasn't consumed yet, so
+  // the many idle connections of a busy server don't pin one each.
+  // Only to be called from this worker's thread.
+  char *get_recv_buf(size_t len) {
+    perf_logger->inc(l_msgr_recv_prefetch_bufs);
+    if (len == recv_buf_len && !free_recv_bufs.empty()) {
+      char *buf = free_recv_bufs.back().release();
+      free_recv_bufs.pop_back();
+      return buf;
+    }
+    perf_logger->inc(l_msgr_recv_prefetch_bufs_allocated);
+    return new char[len];
+  }
+  void put_recv_buf(char *buf, size_t len) {
+    perf_logger->dec(l_msgr_recv_prefetch_bufs);
+    if (len != recv_buf_len) {
+      // ms_tcp_prefetch_max_size changed
+      free_recv_bufs.clear();
+      recv_buf_len = len;
+    }
+    if (free_recv_bufs.size() < MAX_FREE_RECV_BUFS) {
+      free_recv_bufs.emplace_back(buf);
+    } else {
+      delete[] buf;
+    }
+  }
   void release_worker() {
     int oldref = references.fetch_sub(1);
     ceph_assert(oldref > 0);
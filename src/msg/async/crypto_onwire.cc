@@ -2,6 +2,7 @@
 // vim: ts=8 sw=2 smarttab
 
 #include <array>
+#include <utility>
 #include <openssl/evp.h>
 
 #include "crypto_onwire.h"
@@ -19,6 +20,10 @@ static constexpr const std::size_t AESGCM_IV_LEN{12};
 static constexpr const std::size_t AESGCM_TAG_LEN{16};
 static constexpr const std::size_t AESGCM_BLOCK_LEN{16};
 
+// Plaintext buffers shorter than this are copied into the ciphertext
+// buffer and encrypted in place together with their neighbours.
+static constexpr const std::size_t AESGCM_COALESCE_LEN{1024};
+
 struct nonce_t {
   ceph_le32 fixed;
   ceph_le64 counter;
@@ -42,8 +47,11 @@ class AES128GCM_OnWireTxHandler : public ceph::crypto::onwire::TxHandler {
   nonce_t nonce, initial_nonce;
   bool used_initial_nonce;
   bool new_nonce_format;  // 64-bit counter?
+  ceph::timespan busy_time = ceph::timespan::zero();
   static_assert(sizeof(nonce) == AESGCM_IV_LEN);
 
+  void encrypt(const char* in, char* out, unsigned len);
+
 public:
   AES128GCM_OnWireTxHandler(CephContext* const cct,
 			    const key_t& key,
@@ -76,6 +84,10 @@ public:
 
   void authenticated_encrypt_update(const ceph::bufferlist& plaintext) override;
   ceph::bufferlist authenticated_encrypt_final() override;
+
+  ceph::timespan take_busy_time() override {
+    return std::exchange(busy_time, ceph::timespan::zero());
+  }
 };
 
 void AES128GCM_OnWireTxHandler::reset_tx_handler(const uint32_t* first,
@@ -105,27 +117,55 @@ void AES128GCM_OnWireTxHandler::reset_tx_handler(const uint32_t* first,
   }
 }
 
+void AES128GCM_OnWireTxHandler::encrypt(const char* in, char* out,
+					unsigned len)
+{
+  int update_len = 0;
+
+  if(1 != EVP_EncryptUpdate(ectx.get(),
+	reinterpret_cast<unsigned char*>(out),
+	&update_len,
+	reinterpret_cast<const unsigned char*>(in),
+	len)) {
+    throw std::runtime_error("EVP_EncryptUpdate failed");
+  }
+  ceph_assert_always(update_len >= 0);
+  ceph_assert(static_cast<unsigned>(update_len) == len);
+}
+
 void AES128GCM_OnWireTxHandler::authenticated_encrypt_update(
   const ceph::bufferlist& plaintext)
 {
+  const auto start = ceph::mono_clock::now();
   ceph_assert(buffer.get_append_buffer_unused_tail_length() >=
               plaintext.length());
   auto filler = buffer.append_hole(plaintext.length());
 
+  // A frame is typically made of a few tiny buffers (headers, encoded
+  // fields) and some large ones.  Every EVP_EncryptUpdate() has a fixed
+  // cost and a short one can't use the wide AES-NI/PCLMUL code paths,
+  // so gather the consecutive short buffers in the output and encrypt
+  // them in place with one call; long buffers are encrypted directly.
+  char* run = filler.c_str();
+  unsigned run_len = 0;
   for (const auto& plainbuf : plaintext.buffers()) {
-    int update_len = 0;
-
-    if(1 != EVP_EncryptUpdate(ectx.get(),
-	reinterpret_cast<unsigned char*>(filler.c_str()),
-	&update_len,
-	reinterpret_cast<const unsigned char*>(plainbuf.c_str()),
-	plainbuf.length())) {
-      throw std::runtime_error("EVP_EncryptUpdate failed");
+    if (plainbuf.length() < AESGCM_COALESCE_LEN) {
+      filler.copy_in(plainbuf.length(), plainbuf.c_str());
+      run_len += plainbuf.length();
+      continue;
     }
-    ceph_assert_always(update_len >= 0);
-    ceph_assert(static_cast<unsigned>(update_len) == plainbuf.length());
-    filler.advance(update_len);
+    if (run_len > 0) {
+      encrypt(run, run, run_len);
+    }
+    encrypt(plainbuf.c_str(), filler.c_str(), plainbuf.length());
+    filler.advance(plainbuf.length());
+    run = filler.c_str();
+    run_len = 0;
+  }
+  if (run_len > 0) {
+    encrypt(run, run, run_len);
   }
+  busy_time += ceph::mono_clock::now() - start;
 
   ldout(cct, 15) << __func__
 		 << " plaintext.length()=" << plaintext.length()
@@ -135,6 +175,7 @@ void AES128GCM_OnWireTxHandler::authenticated_encrypt_update(
 
 ceph::bufferlist AES128GCM_OnWireTxHandler::authenticated_encrypt_final()
 {
+  const auto start = ceph::mono_clock::now();
   int final_len = 0;
   ceph_assert(buffer.get_append_buffer_unused_tail_length() ==
               AESGCM_BLOCK_LEN);
@@ -152,6 +193,7 @@ ceph::bufferlist AES128GCM_OnWireTxHandler::authenticated_encrypt_final()
 	filler.c_str())) {
     throw std::runtime_error("EVP_CIPHER_CTX_ctrl failed");
   }
+  busy_time += ceph::mono_clock::now() - start;
 
   ldout(cct, 15) << __func__
 		 << " buffer.length()=" << buffer.length()
@@ -165,6 +207,7 @@ class AES128GCM_OnWireRxHandler : public ceph::crypto::onwire::RxHandler {
   std::unique_ptr<EVP_CIPHER_CTX, decltype(&::EVP_CIPHER_CTX_free)> ectx;
   nonce_t nonce;
   bool new_nonce_format;  // 64-bit counter?
+  ceph::timespan busy_time = ceph::timespan::zero();
   static_assert(sizeof(nonce) == AESGCM_IV_LEN);
 
 public:
@@ -198,6 +241,10 @@ public:
   void reset_rx_handler() override;
   void authenticated_decrypt_update(ceph::bufferlist& bl) override;
   void authenticated_decrypt_update_final(ceph::bufferlist& bl) override;
+
+  ceph::timespan take_busy_time() override {
+    return std::exchange(busy_time, ceph::timespan::zero());
+  }
 };
 
 void AES128GCM_OnWireRxHandler::reset_rx_handler()
@@ -219,6 +266,7 @@ void AES128GCM_OnWireRxHandler::reset_rx_handler()
 void AES128GCM_OnWireRxHandler::authenticated_decrypt_update(
   ceph::bufferlist& bl)
 {
+  const auto start = ceph::mono_clock::now();
   // discard cached crcs as we will be writing through c_str()
   bl.invalidate_crc();
   for (auto& buf : bl.buffers()) {
@@ -231,6 +279,7 @@ void AES128GCM_OnWireRxHandler::authenticated_decrypt_update(
     ceph_assert_always(update_len >= 0);
     ceph_assert(static_cast<unsigned>(update_len) == buf.length());
   }
+  busy_time += ceph::mono_clock::now() - start;
 }
 
 void AES128GCM_OnWireRxHandler::authenticated_decrypt_update_final(
@@ -257,8 +306,11 @@ void AES128GCM_OnWireRxHandler::authenticated_decrypt_update_final(
   // I expect that 0 bytes will be appended. The call is supposed solely to
   // authenticate the message.
   {
+    const auto start = ceph::mono_clock::now();
     int final_len = 0;
-    if (0 >= EVP_DecryptFinal_ex(ectx.get(), nullptr, &final_len)) {
+    int r = EVP_DecryptFinal_ex(ectx.get(), nullptr, &final_len);
+    busy_time += ceph::mono_clock::now() - start;
+    if (0 >= r) {
       throw MsgAuthError();
     }
     ceph_assert_always(final_len == 0);
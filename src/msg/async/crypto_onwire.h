@@ -20,6 +20,7 @@
 #include <memory>
 
 #include "auth/Auth.h"
+#include "common/ceph_time.h"
 #include "include/buffer.h"
 
 namespace ceph::math {
@@ -86,6 +87,10 @@ struct TxHandler {
   // Generates authentication signature and returns bufferlist crafted
   // basing on plaintext from preceding call to _update().
   virtual ceph::bufferlist authenticated_encrypt_final() = 0;
+
+  // Returns the time spent in the cipher since the previous call, so
+  // that the cost of encryption can be charged to the connection.
+  virtual ceph::timespan take_busy_time() = 0;
 };
 
 class RxHandler {
@@ -109,6 +114,9 @@ public:
   // for overall decryption sequence.
   // Throws on integrity/authenticity checks
   virtual void authenticated_decrypt_update_final(ceph::bufferlist& bl) = 0;
+
+  // Returns the time spent in the cipher since the previous call.
+  virtual ceph::timespan take_busy_time() = 0;
 };
 
 struct rxtx_t {
@@ -184,7 +184,7 @@ public:
     m_is_rev1 = is_rev1;
   }
 
-  bool get_is_rev1() {
+  bool get_is_rev1() const {
     return m_is_rev1;
   }
 
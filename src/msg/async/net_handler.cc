@@ -125,6 +125,22 @@ int NetHandler::set_socket_options(int sd, bool nodelay, int size)
   return -r;
 }
 
+bool NetHandler::set_zerocopy(int sd)
+{
+#if defined(SO_ZEROCOPY) && defined(MSG_ZEROCOPY)
+  int val = 1;
+  int r = ::setsockopt(sd, SOL_SOCKET, SO_ZEROCOPY, (SOCKOPT_VAL_TYPE)&val, sizeof(val));
+  if (r < 0) {
+    r = errno;
+    ldout(cct, 1) << "couldn't set SO_ZEROCOPY: " << cpp_strerror(r) << dendl;
+    return false;
+  }
+  return true;
+#else
+  return false;
+#endif
+}
+
 void NetHandler::set_priority(int sd, int prio, int domain)
 {
 #ifdef SO_PRIORITY
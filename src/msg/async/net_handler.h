@@ -40,6 +40,8 @@ namespace ceph {
     int reconnect(const entity_addr_t &addr, int sd);
     int nonblock_connect(const entity_addr_t &addr, const entity_addr_t& bind_addr);
     void set_priority(int sd, int priority, int domain);
+    /// enable SO_ZEROCOPY; returns false if the kernel does not support it
+    bool set_zerocopy(int sd);
   };
 }
 
@@ -0,0 +1,457 @@
+// -*- mode:C++; tab-width:8; c-basic-offset:2; indent-tabs-mode:t -*-
+// vim: ts=8 sw=2 smarttab
+/*
+ * Ceph - scalable distributed file system
+ *
+ * This is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License version 2.1, as published by the Free Software
+ * Foundation.  See file COPYING.
+ *
+ */
+
+#include <limits.h>
+#include <poll.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "common/errno.h"
+#include "EventUring.h"
+#include "UringStack.h"
+
+#define dout_subsys ceph_subsys_ms
+
+#undef dout_prefix
+#define dout_prefix *_dout << "UringDriver."
+
+UringDriver::SendOp::SendOp(int fd, UringConnectedSocketImpl *s,
+			    ceph::buffer::list &&b)
+  : Op(type_t::SEND, fd), sock(s), bl(std::move(b))
+{
+  iov.reserve(bl.get_num_buffers());
+  for (auto& p : bl.buffers()) {
+    iov.push_back({const_cast<char*>(p.c_str()), p.length()});
+  }
+  // FIPS zeroization audit 20191115: this memset is not security related.
+  memset(&msg, 0, sizeof(msg));
+  msg.msg_iov = iov.data();
+  msg.msg_iovlen = iov.size();
+}
+
+UringDriver::~UringDriver()
+{
+  if (ring_inited) {
+    if (buf_ring) {
+      io_uring_free_buf_ring(&ring, buf_ring, nbufs, RECV_BGID);
+    }
+    io_uring_queue_exit(&ring);
+  }
+  // the ring is gone, and with it every completion still owed to us
+  ops.clear_and_dispose([](Op *op) {
+    if (op->type == Op::type_t::SEND && static_cast<SendOp*>(op)->lingering) {
+      ::close(op->fd);
+    }
+    delete op;
+  });
+  free(bufs);
+}
+
+int UringDriver::init(EventCenter *c, int nevent)
+{
+  unsigned entries =
+    cct->_conf.get_val<uint64_t>("ms_async_uring_queue_depth");
+  int r = io_uring_queue_init(entries, &ring, 0);
+  if (r < 0) {
+    lderr(cct) << __func__ << " unable to set up io_uring: "
+	       << cpp_strerror(r) << dendl;
+    return r;
+  }
+  ring_inited = true;
+
+  nbufs = cct->_conf.get_val<uint64_t>("ms_async_uring_recv_buffers");
+  buf_size = cct->_conf.get_val<Option::size_t>("ms_async_uring_recv_buffer_size");
+  if (!nbufs || (nbufs & (nbufs - 1))) {
+    lderr(cct) << __func__ << " ms_async_uring_recv_buffers=" << nbufs
+	       << " is not a power of two" << dendl;
+    return -EINVAL;
+  }
+  if (posix_memalign((void**)&bufs, CEPH_PAGE_SIZE, (size_t)nbufs * buf_size)) {
+    lderr(cct) << __func__ << " unable to allocate " << nbufs
+	       << " recv buffers" << dendl;
+    return -ENOMEM;
+  }
+  buf_ring = io_uring_setup_buf_ring(&ring, nbufs, RECV_BGID, 0, &r);
+  if (!buf_ring) {
+    // multishot recv with a buffer ring needs Linux 6.0
+    lderr(cct) << __func__ << " unable to register recv buffer ring: "
+	       << cpp_strerror(r) << dendl;
+    return r;
+  }
+  for (unsigned bid = 0; bid < nbufs; bid++) {
+    io_uring_buf_ring_add(buf_ring, bufs + (size_t)bid * buf_size, buf_size,
+			  bid, io_uring_buf_ring_mask(nbufs), bid);
+  }
+  io_uring_buf_ring_advance(buf_ring, nbufs);
+
+  resize_events(nevent);
+  return 0;
+}
+
+int UringDriver::resize_events(int newsize)
+{
+  if (newsize > nevent) {
+    polls.resize(newsize, nullptr);
+    sockets.resize(newsize, nullptr);
+    fired_mask.resize(newsize, 0);
+    nevent = newsize;
+  }
+  return 0;
+}
+
+struct io_uring_sqe *UringDriver::get_sqe()
+{
+  struct io_uring_sqe *sqe = io_uring_get_sqe(&ring);
+  while (!sqe) {
+    // the submission queue is full; hand it over early
+    int r = io_uring_submit(&ring);
+    if (r < 0 && r != -EAGAIN && r != -EBUSY && r != -EINTR) {
+      lderr(cct) << __func__ << " io_uring_submit failed: "
+		 << cpp_strerror(r) << dendl;
+      ceph_abort_msg("io_uring_submit failed");
+    }
+    sqe = io_uring_get_sqe(&ring);
+  }
+  return sqe;
+}
+
+void UringDriver::submit_op(struct io_uring_sqe *sqe, Op *op)
+{
+  io_uring_sqe_set_data(sqe, op);
+  if (!op->is_linked()) {
+    ops.push_back(*op);
+  }
+}
+
+void UringDriver::cancel_op(Op *op)
+{
+  if (op->cancelled) {
+    return;
+  }
+  op->cancelled = true;
+  struct io_uring_sqe *sqe = get_sqe();
+  io_uring_prep_cancel(sqe, op, 0);
+  // the cancel request completes on its own; nothing to do with it
+  io_uring_sqe_set_data(sqe, nullptr);
+}
+
+void UringDriver::arm_poll(PollOp *op)
+{
+  unsigned poll_mask = 0;
+  if (op->mask & EVENT_READABLE)
+    poll_mask |= POLLIN;
+  if (op->mask & EVENT_WRITABLE)
+    poll_mask |= POLLOUT;
+  struct io_uring_sqe *sqe = get_sqe();
+  io_uring_prep_poll_multishot(sqe, op->fd, poll_mask);
+  submit_op(sqe, op);
+}
+
+void UringDriver::arm_recv(RecvOp *op)
+{
+  struct io_uring_sqe *sqe = get_sqe();
+  io_uring_prep_recv_multishot(sqe, op->fd, nullptr, 0, 0);
+  io_uring_sqe_set_flags(sqe, IOSQE_BUFFER_SELECT);
+  sqe->buf_group = RECV_BGID;
+  submit_op(sqe, op);
+}
+
+void UringDriver::recycle_buf(unsigned bid)
+{
+  io_uring_buf_ring_add(buf_ring, bufs + (size_t)bid * buf_size, buf_size,
+			bid, io_uring_buf_ring_mask(nbufs), 0);
+  io_uring_buf_ring_advance(buf_ring, 1);
+}
+
+void UringDriver::update_poll(int fd, int mask)
+{
+  if (polls[fd]) {
+    if (polls[fd]->mask == mask) {
+      return;
+    }
+    cancel_op(polls[fd]);
+    polls[fd] = nullptr;
+  }
+  if (mask) {
+    polls[fd] = new PollOp(fd, mask);
+    arm_poll(polls[fd]);
+  }
+}
+
+int UringDriver::add_event(int fd, int cur_mask, int add_mask)
+{
+  ldout(cct, 20) << __func__ << " add event fd=" << fd << " cur_mask=" << cur_mask
+		 << " add_mask=" << add_mask << dendl;
+  resize_events(fd + 1);
+  int mask = cur_mask | add_mask;
+  UringConnectedSocketImpl *s = sockets[fd];
+  if (s) {
+    // readability of our own sockets comes from their recv, and
+    // writability from the room in their send queue
+    if ((add_mask & EVENT_READABLE) && s->has_pending_events()) {
+      fire(fd, EVENT_READABLE);
+    }
+    mask &= ~EVENT_READABLE;
+    if (s->reports_writable()) {
+      if ((add_mask & EVENT_WRITABLE) && s->can_send()) {
+	fire(fd, EVENT_WRITABLE);
+      }
+      mask &= ~EVENT_WRITABLE;
+    }
+  }
+  update_poll(fd, mask);
+  return 0;
+}
+
+int UringDriver::del_event(int fd, int cur_mask, int del_mask)
+{
+  ldout(cct, 20) << __func__ << " del event fd=" << fd << " cur_mask=" << cur_mask
+		 << " del_mask=" << del_mask << dendl;
+  if (fd >= nevent) {
+    return 0;
+  }
+  int mask = cur_mask & ~del_mask;
+  if (UringConnectedSocketImpl *s = sockets[fd]) {
+    mask &= ~EVENT_READABLE;
+    if (s->reports_writable()) {
+      mask &= ~EVENT_WRITABLE;
+    }
+  }
+  update_poll(fd, mask);
+  return 0;
+}
+
+void UringDriver::fire(int fd, int mask)
+{
+  ceph_assert(fd < nevent);
+  if (!fired_mask[fd]) {
+    fired_fds.push_back(fd);
+  }
+  fired_mask[fd] |= mask;
+}
+
+void UringDriver::attach_socket(int fd, UringConnectedSocketImpl *s)
+{
+  resize_events(fd + 1);
+  ceph_assert(!sockets[fd]);
+  sockets[fd] = s;
+}
+
+void UringDriver::detach_socket(int fd)
+{
+  ceph_assert(fd < nevent);
+  sockets[fd] = nullptr;
+}
+
+UringDriver::RecvOp *UringDriver::start_recv(int fd, UringConnectedSocketImpl *s)
+{
+  RecvOp *op = new RecvOp(fd, s);
+  arm_recv(op);
+  return op;
+}
+
+UringDriver::SendOp *UringDriver::start_send(int fd, UringConnectedSocketImpl *s,
+					     ceph::buffer::list &&bl, bool more)
+{
+  SendOp *op = new SendOp(fd, s, std::move(bl));
+  struct io_uring_sqe *sqe = get_sqe();
+  io_uring_prep_sendmsg(sqe, fd, &op->msg,
+			MSG_NOSIGNAL | MSG_WAITALL | (more ? MSG_MORE : 0));
+  submit_op(sqe, op);
+  return op;
+}
+
+void UringDriver::take_sendable(ceph::buffer::list &bl, ceph::buffer::list *out)
+{
+  if (bl.get_num_buffers() <= IOV_MAX) {
+    out->claim_append(bl);
+    return;
+  }
+  unsigned len = 0, n = 0;
+  for (auto& p : bl.buffers()) {
+    if (n++ == IOV_MAX)
+      break;
+    len += p.length();
+  }
+  bl.splice(0, len, out);
+}
+
+void UringDriver::send_lingering(int fd, ceph::buffer::list &&bl)
+{
+  ceph::buffer::list now;
+  take_sendable(bl, &now);
+  SendOp *op = start_send(fd, nullptr, std::move(now), bl.length());
+  op->lingering = true;
+  op->rest = std::move(bl);
+}
+
+void UringDriver::linger(int fd, SendOp *op, ceph::buffer::list &&bl)
+{
+  ldout(cct, 20) << __func__ << " fd=" << fd << " closing with "
+		 << (op ? op->bl.length() : 0) + bl.length()
+		 << " bytes to send" << dendl;
+  if (op) {
+    op->sock = nullptr;
+    op->lingering = true;
+    op->rest = std::move(bl);
+  } else {
+    send_lingering(fd, std::move(bl));
+  }
+}
+
+void UringDriver::handle_lingering(SendOp *op, int r)
+{
+  ceph::buffer::list rest;
+  if (r < 0) {
+    ldout(cct, 1) << __func__ << " fd=" << op->fd << " dropping "
+		  << op->bl.length() + op->rest.length()
+		  << " bytes after send error: " << cpp_strerror(r) << dendl;
+  } else {
+    if ((unsigned)r < op->bl.length()) {
+      op->bl.splice(r, op->bl.length() - r, &rest);
+    }
+    rest.claim_append(op->rest);
+  }
+  if (rest.length()) {
+    send_lingering(op->fd, std::move(rest));
+  } else {
+    ::close(op->fd);
+  }
+}
+
+void UringDriver::handle_cqe(struct io_uring_cqe *cqe)
+{
+  Op *op = static_cast<Op*>(io_uring_cqe_get_data(cqe));
+  if (!op) {
+    return;
+  }
+  bool more = cqe->flags & IORING_CQE_F_MORE;
+  switch (op->type) {
+  case Op::type_t::POLL:
+    {
+      auto p = static_cast<PollOp*>(op);
+      if (!op->cancelled) {
+	int mask = 0;
+	if (cqe->res < 0) {
+	  ldout(cct, 1) << __func__ << " poll on fd=" << op->fd << " failed: "
+			<< cpp_strerror(cqe->res) << dendl;
+	  mask = EVENT_READABLE | EVENT_WRITABLE;
+	} else {
+	  if (cqe->res & POLLIN) mask |= EVENT_READABLE;
+	  if (cqe->res & POLLOUT) mask |= EVENT_WRITABLE;
+	  if (cqe->res & (POLLERR | POLLHUP)) mask |= EVENT_READABLE | EVENT_WRITABLE;
+	}
+	fire(op->fd, mask & p->mask);
+	if (!more && cqe->res >= 0) {
+	  // the kernel may end a multishot poll, e.g. on cq overflow
+	  arm_poll(p);
+	  return;
+	}
+      }
+      if (!more) {
+	if (polls[op->fd] == p) {
+	  polls[op->fd] = nullptr;
+	}
+	ops.erase(ops.iterator_to(*op));
+	delete op;
+      }
+    }
+    break;
+
+  case Op::type_t::RECV:
+    {
+      auto p = static_cast<RecvOp*>(op);
+      const char *buf = nullptr;
+      if (cqe->flags & IORING_CQE_F_BUFFER) {
+	unsigned bid = cqe->flags >> IORING_CQE_BUFFER_SHIFT;
+	buf = bufs + (size_t)bid * buf_size;
+	if (p->sock) {
+	  p->sock->handle_recv(buf, cqe->res);
+	}
+	recycle_buf(bid);
+      } else if (p->sock && cqe->res != -ENOBUFS && cqe->res != -ECANCELED) {
+	// eof or error
+	p->sock->handle_recv(nullptr, cqe->res);
+      }
+      if (p->sock) {
+	fire(op->fd, EVENT_READABLE);
+      }
+      if (!more) {
+	ops.erase(ops.iterator_to(*op));
+	if (p->sock) {
+	  // rearms unless the socket is done with receiving
+	  p->sock->handle_recv_done();
+	}
+	delete op;
+      }
+    }
+    break;
+
+  case Op::type_t::SEND:
+    {
+      auto p = static_cast<SendOp*>(op);
+      if (p->sock) {
+	p->sock->handle_send(cqe->res);
+      } else if (p->lingering) {
+	handle_lingering(p, cqe->res);
+      }
+      if (!more) {
+	ops.erase(ops.iterator_to(*op));
+	delete op;
+      }
+    }
+    break;
+  }
+}
+
+int UringDriver::event_wait(std::vector<FiredFileEvent> &fired_events,
+			    struct timeval *tvp)
+{
+  struct __kernel_timespec ts = {0, 0};
+  struct __kernel_timespec *tsp = nullptr;
+  if (!fired_fds.empty()) {
+    // already have something to report; only submit and reap
+    tsp = &ts;
+  } else if (tvp) {
+    ts.tv_sec = tvp->tv_sec;
+    ts.tv_nsec = tvp->tv_usec * 1000;
+    tsp = &ts;
+  }
+
+  struct io_uring_cqe *cqe;
+  int r = io_uring_submit_and_wait_timeout(&ring, &cqe, 1, tsp, nullptr);
+  if (r < 0 && r != -ETIME && r != -EINTR) {
+    lderr(cct) << __func__ << " io_uring_submit_and_wait_timeout failed: "
+	       << cpp_strerror(r) << dendl;
+  }
+
+  unsigned head, count = 0;
+  io_uring_for_each_cqe(&ring, head, cqe) {
+    handle_cqe(cqe);
+    count++;
+  }
+  io_uring_cq_advance(&ring, count);
+
+  int numevents = 0;
+  fired_events.resize(fired_fds.size());
+  for (int fd : fired_fds) {
+    if (fired_mask[fd]) {
+      fired_events[numevents].fd = fd;
+      fired_events[numevents].mask = fired_mask[fd];
+      numevents++;
+    }
+    fired_mask[fd] = 0;
+  }
+  fired_events.resize(numevents);
+  fired_fds.clear();
+  return numevents;
+}
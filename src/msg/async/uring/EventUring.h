@@ -0,0 +1,137 @@
+// -*- mode:C++; tab-width:8; c-basic-offset:2; indent-tabs-mode:t -*-
+// vim: ts=8 sw=2 smarttab
+/*
+ * Ceph - scalable distributed file system
+ *
+ * This is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License version 2.1, as published by the Free Software
+ * Foundation.  See file COPYING.
+ *
+ */
+
+#ifndef CEPH_MSG_EVENTURING_H
+#define CEPH_MSG_EVENTURING_H
+
+#include <sys/socket.h>
+#include <vector>
+
+#include <boost/intrusive/list.hpp>
+#include <liburing.h>
+
+#include "msg/async/Event.h"
+#include "include/buffer.h"
+
+class UringConnectedSocketImpl;
+
+/*
+ * An EventDriver on top of io_uring.  Plain fds are watched with
+ * multishot polls instead of epoll_ctl.  Sockets of the uring network
+ * stack go further: the driver keeps a multishot recv armed on them,
+ * feeding a ring of provided buffers, and reports the socket readable
+ * once data has actually been received.  Every request queued while
+ * the event loop runs -- poll changes, sends, rearms -- is submitted
+ * together with the wait for the next completions, so a loop
+ * iteration costs one io_uring_enter(2) however many connections it
+ * served.
+ */
+class UringDriver : public EventDriver {
+ public:
+  // an in-flight request; io_uring user_data points to it
+  struct Op : public boost::intrusive::list_base_hook<> {
+    enum class type_t { POLL, RECV, SEND };
+    const type_t type;
+    const int fd;
+    // set once the request was cancelled or its owner went away; the
+    // op is freed when its last completion arrives
+    bool cancelled = false;
+    Op(type_t t, int fd) : type(t), fd(fd) {}
+    virtual ~Op() {}
+  };
+  struct PollOp : public Op {
+    int mask;
+    PollOp(int fd, int mask) : Op(type_t::POLL, fd), mask(mask) {}
+  };
+  // sock is cleared when the socket closes; until then completions
+  // are delivered to it, even after the op was cancelled
+  struct RecvOp : public Op {
+    UringConnectedSocketImpl *sock;
+    RecvOp(int fd, UringConnectedSocketImpl *s)
+      : Op(type_t::RECV, fd), sock(s) {}
+  };
+  struct SendOp : public Op {
+    UringConnectedSocketImpl *sock;
+    // the socket closed with more to send: what follows bl, and the fd
+    // is the driver's to close once it is out
+    bool lingering = false;
+    ceph::buffer::list rest;
+    ceph::buffer::list bl;
+    std::vector<struct iovec> iov;
+    struct msghdr msg;
+    SendOp(int fd, UringConnectedSocketImpl *s, ceph::buffer::list &&b);
+  };
+
+ private:
+  CephContext *cct;
+  struct io_uring ring;
+  bool ring_inited = false;
+  int nevent = 0;
+
+  boost::intrusive::list<Op> ops;
+  // per fd: the multishot poll watching it, if any
+  std::vector<PollOp*> polls;
+  // per fd: the uring stack socket using it, if any
+  std::vector<UringConnectedSocketImpl*> sockets;
+
+  // events fired since the last event_wait()
+  std::vector<int> fired_mask;
+  std::vector<int> fired_fds;
+
+  // provided buffers for multishot recv
+  static constexpr int RECV_BGID = 0;
+  struct io_uring_buf_ring *buf_ring = nullptr;
+  char *bufs = nullptr;
+  unsigned nbufs = 0;
+  unsigned buf_size = 0;
+
+  struct io_uring_sqe *get_sqe();
+  void submit_op(struct io_uring_sqe *sqe, Op *op);
+  void cancel_op(Op *op);
+  void arm_poll(PollOp *op);
+  void update_poll(int fd, int mask);
+  void arm_recv(RecvOp *op);
+  void recycle_buf(unsigned bid);
+  void send_lingering(int fd, ceph::buffer::list &&bl);
+  void handle_lingering(SendOp *op, int r);
+  void handle_cqe(struct io_uring_cqe *cqe);
+
+ public:
+  explicit UringDriver(CephContext *c) : cct(c) {}
+  ~UringDriver() override;
+
+  int init(EventCenter *c, int nevent) override;
+  int add_event(int fd, int cur_mask, int add_mask) override;
+  int del_event(int fd, int cur_mask, int del_mask) override;
+  int resize_events(int newsize) override;
+  int event_wait(std::vector<FiredFileEvent> &fired_events,
+		 struct timeval *tp) override;
+
+  void fire(int fd, int mask);
+
+  // used by UringConnectedSocketImpl, from the owning worker's thread
+  void attach_socket(int fd, UringConnectedSocketImpl *s);
+  void detach_socket(int fd);
+  RecvOp *start_recv(int fd, UringConnectedSocketImpl *s);
+  SendOp *start_send(int fd, UringConnectedSocketImpl *s,
+		     ceph::buffer::list &&bl, bool more);
+  void stop(Op *op) {
+    cancel_op(op);
+  }
+  // takes over the fd of a closing socket until the send in flight, if
+  // any, and then bl are sent
+  void linger(int fd, SendOp *op, ceph::buffer::list &&bl);
+  // moves as much of bl as one sendmsg takes to the end of *out
+  static void take_sendable(ceph::buffer::list &bl, ceph::buffer::list *out);
+};
+
+#endif
@@ -0,0 +1,347 @@
+// -*- mode:C++; tab-width:8; c-basic-offset:2; indent-tabs-mode:t -*-
+// vim: ts=8 sw=2 smarttab
+/*
+ * Ceph - scalable distributed file system
+ *
+ * This is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License version 2.1, as published by the Free Software
+ * Foundation.  See file COPYING.
+ *
+ */
+
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <errno.h>
+
+#include "UringStack.h"
+
+#include "include/buffer.h"
+#include "include/compat.h"
+#include "include/sock_compat.h"
+#include "common/errno.h"
+#include "common/dout.h"
+
+#define dout_subsys ceph_subsys_ms
+#undef dout_prefix
+#define dout_prefix *_dout << "UringStack "
+
+UringConnectedSocketImpl::UringConnectedSocketImpl(
+  UringDriver *d, ceph::NetHandler &h, const entity_addr_t &sa, int f,
+  bool connected, uint64_t rx_max, uint64_t tx_max)
+  : driver(d), handler(h), _fd(f), sa(sa), connected(connected),
+    rx_max(rx_max), tx_max(tx_max)
+{
+  driver->attach_socket(_fd, this);
+  if (connected) {
+    start_recv();
+  }
+}
+
+UringConnectedSocketImpl::~UringConnectedSocketImpl()
+{
+  close();
+}
+
+void UringConnectedSocketImpl::start_recv()
+{
+  if (!recv_op && !rx_eof && !rx_error) {
+    recv_op = driver->start_recv(_fd, this);
+  }
+}
+
+int UringConnectedSocketImpl::is_connected()
+{
+  if (connected)
+    return 1;
+
+  int r = handler.reconnect(sa, _fd);
+  if (r == 0) {
+    connected = true;
+    start_recv();
+    return 1;
+  } else if (r < 0) {
+    return r;
+  } else {
+    return 0;
+  }
+}
+
+ssize_t UringConnectedSocketImpl::read(char *buf, size_t len)
+{
+  if (rx_queue.length()) {
+    size_t n = std::min<size_t>(len, rx_queue.length());
+    rx_queue.begin().copy(n, buf);
+    rx_queue.splice(0, n);
+    if (recv_paused && rx_queue.length() <= rx_max / 2) {
+      recv_paused = false;
+      start_recv();
+    }
+    return n;
+  }
+  if (rx_error)
+    return rx_error;
+  if (tx_error)
+    return tx_error;
+  if (rx_eof)
+    return 0;
+  return -EAGAIN;
+}
+
+void UringConnectedSocketImpl::handle_recv(const char *buf, int r)
+{
+  if (r > 0) {
+    rx_queue.append(buf, r);
+    if (rx_queue.length() > rx_max && recv_op && !recv_paused) {
+      // the reader has fallen behind; leave the rest in the socket
+      // buffer so that tcp pushes back on the sender
+      recv_paused = true;
+      driver->stop(recv_op);
+    }
+  } else if (r == 0) {
+    rx_eof = true;
+  } else {
+    rx_error = r;
+  }
+}
+
+void UringConnectedSocketImpl::handle_recv_done()
+{
+  recv_op = nullptr;
+  if (!recv_paused) {
+    start_recv();
+  }
+}
+
+void UringConnectedSocketImpl::flush_tx()
+{
+  if (send_op || tx_error || !tx_queue.length()) {
+    return;
+  }
+  UringDriver::take_sendable(tx_queue, &tx_inflight);
+  ceph::buffer::list bl = tx_inflight;
+  send_op = driver->start_send(_fd, this, std::move(bl), tx_queue.length());
+}
+
+void UringConnectedSocketImpl::handle_send(int r)
+{
+  send_op = nullptr;
+  if (r < 0) {
+    tx_error = r;
+    tx_inflight.clear();
+    tx_queue.clear();
+    // surface it on both sides, as epoll would with EPOLLERR
+    driver->fire(_fd, EVENT_READABLE | EVENT_WRITABLE);
+    return;
+  }
+  if ((unsigned)r < tx_inflight.length()) {
+    ceph::buffer::list rest;
+    tx_inflight.splice(r, tx_inflight.length() - r, &rest);
+    rest.claim_append(tx_queue);
+    tx_queue.swap(rest);
+  }
+  tx_inflight.clear();
+  flush_tx();
+  if (tx_shutdown && !send_op) {
+    ::shutdown(_fd, SHUT_WR);
+  }
+  if (r > 0) {
+    // there is room in the send queue again
+    driver->fire(_fd, EVENT_WRITABLE);
+  }
+}
+
+ssize_t UringConnectedSocketImpl::send(ceph::buffer::list &bl, bool more)
+{
+  if (tx_error)
+    return tx_error;
+  if (tx_shutdown)
+    return -EPIPE;
+  uint64_t queued = tx_queue.length() + tx_inflight.length();
+  if (queued >= tx_max) {
+    // like a full socket buffer: the caller keeps the data and waits
+    // for EVENT_WRITABLE, fired by the next send completion
+    return 0;
+  }
+  ssize_t len = std::min<uint64_t>(bl.length(), tx_max - queued);
+  if ((unsigned)len == bl.length()) {
+    tx_queue.claim_append(bl);
+  } else {
+    bl.splice(0, len, &tx_queue);
+  }
+  flush_tx();
+  return len;
+}
+
+void UringConnectedSocketImpl::shutdown()
+{
+  if (send_op || tx_queue.length()) {
+    // what send() accepted still goes out first, as it would from a tcp
+    // send buffer
+    tx_shutdown = true;
+    ::shutdown(_fd, SHUT_RD);
+  } else {
+    ::shutdown(_fd, SHUT_RDWR);
+  }
+}
+
+void UringConnectedSocketImpl::close()
+{
+  if (closed)
+    return;
+  closed = true;
+  if (recv_op) {
+    recv_op->sock = nullptr;
+    driver->stop(recv_op);
+    recv_op = nullptr;
+  }
+  driver->detach_socket(_fd);
+  if (!tx_error && (send_op || tx_queue.length())) {
+    // what send() accepted still goes out, as it would from a tcp send
+    // buffer; the driver closes the fd once it is sent
+    driver->linger(_fd, send_op, std::move(tx_queue));
+    send_op = nullptr;
+    tx_inflight.clear();
+    return;
+  }
+  if (send_op) {
+    // let it finish; it holds on to what it sends
+    send_op->sock = nullptr;
+    send_op = nullptr;
+  }
+  ::close(_fd);
+}
+
+class UringServerSocketImpl : public ServerSocketImpl {
+  ceph::NetHandler &handler;
+  int _fd;
+
+ public:
+  explicit UringServerSocketImpl(ceph::NetHandler &h, int f,
+				 const entity_addr_t& listen_addr, unsigned slot)
+    : ServerSocketImpl(listen_addr.get_type(), slot),
+      handler(h), _fd(f) {}
+  int accept(ConnectedSocket *sock, const SocketOptions &opts, entity_addr_t *out, Worker *w) override;
+  void abort_accept() override {
+    ::close(_fd);
+    _fd = -1;
+  }
+  int fd() const override {
+    return _fd;
+  }
+};
+
+int UringServerSocketImpl::accept(ConnectedSocket *sock, const SocketOptions &opt, entity_addr_t *out, Worker *w) {
+  ceph_assert(sock);
+  sockaddr_storage ss;
+  socklen_t slen = sizeof(ss);
+  int sd = accept_cloexec(_fd, (sockaddr*)&ss, &slen);
+  if (sd < 0) {
+    return -errno;
+  }
+
+  int r = handler.set_nonblock(sd);
+  if (r < 0) {
+    ::close(sd);
+    return -errno;
+  }
+
+  r = handler.set_socket_options(sd, opt.nodelay, opt.rcbuf_size);
+  if (r < 0) {
+    ::close(sd);
+    return -errno;
+  }
+
+  ceph_assert(NULL != out); //out should not be NULL in accept connection
+
+  out->set_type(addr_type);
+  out->set_sockaddr((sockaddr*)&ss);
+  handler.set_priority(sd, opt.priority, out->get_family());
+
+  *sock = ConnectedSocket(
+    static_cast<UringWorker*>(w)->make_socket(*out, sd, true));
+  return 0;
+}
+
+void UringWorker::initialize()
+{
+}
+
+std::unique_ptr<UringConnectedSocketImpl> UringWorker::make_socket(
+  const entity_addr_t &addr, int sd, bool connected)
+{
+  uint64_t rx_max =
+    cct->_conf.get_val<Option::size_t>("ms_async_uring_recv_queue_max");
+  uint64_t tx_max =
+    cct->_conf.get_val<Option::size_t>("ms_async_uring_send_queue_max");
+  return std::make_unique<UringConnectedSocketImpl>(
+    get_driver(), net, addr, sd, connected, rx_max, tx_max);
+}
+
+int UringWorker::listen(entity_addr_t &sa,
+			unsigned addr_slot,
+			const SocketOptions &opt,
+			ServerSocket *sock)
+{
+  int listen_sd = net.create_socket(sa.get_family(), true);
+  if (listen_sd < 0) {
+    return -errno;
+  }
+
+  int r = net.set_nonblock(listen_sd);
+  if (r < 0) {
+    ::close(listen_sd);
+    return -errno;
+  }
+
+  r = net.set_socket_options(listen_sd, opt.nodelay, opt.rcbuf_size);
+  if (r < 0) {
+    ::close(listen_sd);
+    return -errno;
+  }
+
+  r = ::bind(listen_sd, sa.get_sockaddr(), sa.get_sockaddr_len());
+  if (r < 0) {
+    r = -errno;
+    ldout(cct, 10) << __func__ << " unable to bind to " << sa.get_sockaddr()
+                   << ": " << cpp_strerror(r) << dendl;
+    ::close(listen_sd);
+    return r;
+  }
+
+  r = ::listen(listen_sd, cct->_conf->ms_tcp_listen_backlog);
+  if (r < 0) {
+    r = -errno;
+    lderr(cct) << __func__ << " unable to listen on " << sa << ": " << cpp_strerror(r) << dendl;
+    ::close(listen_sd);
+    return r;
+  }
+
+  *sock = ServerSocket(
+    std::unique_ptr<UringServerSocketImpl>(
+      new UringServerSocketImpl(net, listen_sd, sa, addr_slot)));
+  return 0;
+}
+
+int UringWorker::connect(const entity_addr_t &addr, const SocketOptions &opts, ConnectedSocket *socket) {
+  int sd;
+
+  if (opts.nonblock) {
+    sd = net.nonblock_connect(addr, opts.connect_bind_addr);
+  } else {
+    sd = net.connect(addr, opts.connect_bind_addr);
+  }
+
+  if (sd < 0) {
+    return -errno;
+  }
+
+  net.set_priority(sd, opts.priority, addr.get_family());
+  *socket = ConnectedSocket(make_socket(addr, sd, !opts.nonblock));
+  return 0;
+}
+
+UringNetworkStack::UringNetworkStack(CephContext *c, const std::string &t)
+    : NetworkStack(c, t)
+{
+}
@@ -0,0 +1,127 @@
+// -*- mode:C++; tab-width:8; c-basic-offset:2; indent-tabs-mode:t -*-
+// vim: ts=8 sw=2 smarttab
+/*
+ * Ceph - scalable distributed file system
+ *
+ * This is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License version 2.1, as published by the Free Software
+ * Foundation.  See file COPYING.
+ *
+ */
+
+#ifndef CEPH_MSG_ASYNC_URINGSTACK_H
+#define CEPH_MSG_ASYNC_URINGSTACK_H
+
+#include <thread>
+
+#include "msg/msg_types.h"
+#include "msg/async/net_handler.h"
+#include "msg/async/Stack.h"
+
+#include "EventUring.h"
+
+/*
+ * A TCP socket driven by the worker's io_uring.  Received data is
+ * queued as the completions of a multishot recv come in, so read()
+ * does not enter the kernel.  send() queues as much of the buffer as
+ * the send queue has room for; it goes out with the next submission of
+ * the ring, one sendmsg in flight at a time to keep the stream in
+ * order.  Once connected, the socket is writable while the send queue
+ * has room, like a tcp socket with its send buffer.
+ */
+class UringConnectedSocketImpl final : public ConnectedSocketImpl {
+  UringDriver *driver;
+  ceph::NetHandler &handler;
+  int _fd;
+  entity_addr_t sa;
+  bool connected;
+  bool closed = false;
+
+  // stop receiving while this much has been received but not read
+  uint64_t rx_max;
+  ceph::buffer::list rx_queue;
+  bool rx_eof = false;
+  int rx_error = 0;
+  UringDriver::RecvOp *recv_op = nullptr;
+  bool recv_paused = false;
+
+  // stop accepting data while this much is queued or in flight
+  uint64_t tx_max;
+  ceph::buffer::list tx_queue;     // accepted, not yet submitted
+  ceph::buffer::list tx_inflight;  // submitted, not yet completed
+  UringDriver::SendOp *send_op = nullptr;
+  int tx_error = 0;
+  // shut down while sending; the write side follows once the queue drains
+  bool tx_shutdown = false;
+
+  void start_recv();
+  void flush_tx();
+
+ public:
+  UringConnectedSocketImpl(UringDriver *d, ceph::NetHandler &h,
+			   const entity_addr_t &sa, int f, bool connected,
+			   uint64_t rx_max, uint64_t tx_max);
+  ~UringConnectedSocketImpl() override;
+
+  int is_connected() override;
+  ssize_t read(char *buf, size_t len) override;
+  ssize_t send(ceph::buffer::list &bl, bool more) override;
+  void shutdown() override;
+  void close() override;
+  int fd() const override {
+    return _fd;
+  }
+
+  // completions, called by UringDriver
+  void handle_recv(const char *buf, int r);
+  void handle_recv_done();
+  void handle_send(int r);
+  bool has_pending_events() const {
+    return rx_queue.length() || rx_eof || rx_error || tx_error;
+  }
+  // until connected, writability is the kernel's to report
+  bool reports_writable() const {
+    return connected;
+  }
+  bool can_send() const {
+    return tx_error || tx_queue.length() + tx_inflight.length() < tx_max;
+  }
+};
+
+class UringWorker : public Worker {
+  ceph::NetHandler net;
+  void initialize() override;
+  UringDriver *get_driver() {
+    return static_cast<UringDriver*>(center.get_driver());
+  }
+ public:
+  UringWorker(CephContext *c, unsigned i)
+      : Worker(c, i), net(c) {}
+  int listen(entity_addr_t &sa,
+	     unsigned addr_slot,
+	     const SocketOptions &opt,
+	     ServerSocket *socks) override;
+  int connect(const entity_addr_t &addr, const SocketOptions &opts,
+	      ConnectedSocket *socket) override;
+  std::unique_ptr<UringConnectedSocketImpl> make_socket(
+    const entity_addr_t &addr, int sd, bool connected);
+};
+
+class UringNetworkStack : public NetworkStack {
+  std::vector<std::thread> threads;
+
+ public:
+  explicit UringNetworkStack(CephContext *c, const std::string &t);
+
+  void spawn_worker(unsigned i, std::function<void ()> &&func) override {
+    threads.resize(i+1);
+    threads[i] = std::thread(func);
+  }
+  void join_worker(unsigned i) override {
+    ceph_assert(threads.size() > i && threads[i].joinable());
+    threads[i].join();
+  }
+};
+
+#endif //CEPH_MSG_ASYNC_URINGSTACK_H
@@ -542,6 +542,35 @@ public:
      return total;
    }
 
+  /**
+   * digest -- crc32c of a byte range of an object, as read would see it
+   *
+   * The default implementation reads the range and hashes it.  A store
+   * that knows which ranges are unallocated, and so read back as zeros,
+   * may override this to fold those into the crc without reading them.
+   *
+   * @param cid collection for object
+   * @param oid oid of object
+   * @param offset location offset of first byte to be digested
+   * @param len number of bytes to be digested
+   * @param crc [in/out] crc32c seed, updated with the digested bytes
+   * @param op_flags is CEPH_OSD_OP_FLAG_*
+   * @returns number of bytes digested on success, or negative error code on failure.
+   */
+   virtual int digest(
+     CollectionHandle &c,
+     const ghobject_t& oid,
+     uint64_t offset,
+     size_t len,
+     uint32_t *crc,
+     uint32_t op_flags = 0) {
+     ceph::buffer::list bl;
+     int r = read(c, oid, offset, len, bl, op_flags);
+     if (r > 0)
+       *crc = bl.crc32c(*crc);
+     return r;
+   }
+
   /**
    * dump_onode -- dumps onode metadata in human readable form,
      intended primiarily for debugging
@@ -9732,6 +9732,55 @@ int BlueStore::_decompress(bufferlist& source, bufferlist* result)
 
 // this stores fiemap into interval_set, other variations
 // use it internally
+void BlueStore::_fiemap_onode(
+  OnodeRef o,
+  uint64_t offset,
+  size_t length,
+  interval_set<uint64_t>& destset)
+{
+  dout(20) << __func__ << " 0x" << std::hex << offset << "~" << length
+	   << " size 0x" << o->onode.size << std::dec << dendl;
+
+  if (offset >= o->onode.size)
+    return;
+
+  if (offset + length > o->onode.size) {
+    length = o->onode.size - offset;
+  }
+
+  o->extent_map.fault_range(db, offset, length);
+  auto eend = o->extent_map.extent_map.end();
+  auto ep = o->extent_map.seek_lextent(offset);
+  while (length > 0) {
+    dout(20) << __func__ << " offset " << offset << dendl;
+    if (ep != eend && ep->logical_offset + ep->length <= offset) {
+      ++ep;
+      continue;
+    }
+
+    uint64_t x_len = length;
+    if (ep != eend && ep->logical_offset <= offset) {
+      uint64_t x_off = offset - ep->logical_offset;
+      x_len = std::min(x_len, ep->length - x_off);
+      dout(30) << __func__ << " lextent 0x" << std::hex << offset << "~"
+	       << x_len << std::dec << " blob " << ep->blob << dendl;
+      destset.insert(offset, x_len);
+      length -= x_len;
+      offset += x_len;
+      if (x_off + x_len == ep->length)
+	++ep;
+      continue;
+    }
+    if (ep != eend &&
+	ep->logical_offset > offset &&
+	ep->logical_offset - offset < x_len) {
+      x_len = ep->logical_offset - offset;
+    }
+    offset += x_len;
+    length -= x_len;
+  }
+}
+
 int BlueStore::_fiemap(
   CollectionHandle &c_,
   const ghobject_t& oid,
@@ -9751,51 +9800,9 @@ int BlueStore::_fiemap(
     }
     _dump_onode<30>(cct, *o);
 
-    dout(20) << __func__ << " 0x" << std::hex << offset << "~" << length
-	     << " size 0x" << o->onode.size << std::dec << dendl;
-
-    boost::intrusive::set<Extent>::iterator ep, eend;
-    if (offset >= o->onode.size)
-      goto out;
-
-    if (offset + length > o->onode.size) {
-      length = o->onode.size - offset;
-    }
-
-    o->extent_map.fault_range(db, offset, length);
-    eend = o->extent_map.extent_map.end();
-    ep = o->extent_map.seek_lextent(offset);
-    while (length > 0) {
-      dout(20) << __func__ << " offset " << offset << dendl;
-      if (ep != eend && ep->logical_offset + ep->length <= offset) {
-        ++ep;
-        continue;
-      }
-
-      uint64_t x_len = length;
-      if (ep != eend && ep->logical_offset <= offset) {
-        uint64_t x_off = offset - ep->logical_offset;
-        x_len = std::min(x_len, ep->length - x_off);
-        dout(30) << __func__ << " lextent 0x" << std::hex << offset << "~"
-	         << x_len << std::dec << " blob " << ep->blob << dendl;
-        destset.insert(offset, x_len);
-        length -= x_len;
-        offset += x_len;
-        if (x_off + x_len == ep->length)
-	  ++ep;
-        continue;
-      }
-      if (ep != eend &&
-	  ep->logical_offset > offset &&
-	  ep->logical_offset - offset < x_len) {
-        x_len = ep->logical_offset - offset;
-      }
-      offset += x_len;
-      length -= x_len;
-    }
+    _fiemap_onode(o, offset, length, destset);
   }
 
- out:
   dout(20) << __func__ << " 0x" << std::hex << offset << "~" << length
 	   << " size = 0x(" << destset << ")" << std::dec << dendl;
   return 0;
@@ -9831,6 +9838,89 @@ int BlueStore::fiemap(
   return r;
 }
 
+int BlueStore::digest(
+  CollectionHandle &c_,
+  const ghobject_t& oid,
+  uint64_t offset,
+  size_t length,
+  uint32_t *crc,
+  uint32_t op_flags)
+{
+  auto start = mono_clock::now();
+  Collection *c = static_cast<Collection *>(c_.get());
+  const coll_t &cid = c->get_cid();
+  dout(15) << __func__ << " " << cid << " " << oid
+	   << " 0x" << std::hex << offset << "~" << length << std::dec
+	   << dendl;
+  if (!c->exists)
+    return -ENOENT;
+
+  int r = 0;
+  {
+    std::shared_lock l(c->lock);
+    OnodeRef o = c->get_onode(oid, false);
+    if (!o || !o->exists) {
+      r = -ENOENT;
+      goto out;
+    }
+    if (offset >= o->onode.size) {
+      goto out;
+    }
+    length = std::min<uint64_t>(length, o->onode.size - offset);
+
+    // only read what is allocated; unwritten ranges read back as zeros,
+    // and so are folded into the crc without touching the disk
+    interval_set<uint64_t> m;
+    _fiemap_onode(o, offset, length, m);
+    bufferlist bl;
+    if (!m.empty()) {
+      r = _do_readv(c, o, m, bl, op_flags);
+      if (r < 0) {
+	if (r == -EIO) {
+	  logger->inc(l_bluestore_read_eio);
+	}
+	goto out;
+      }
+    }
+    uint64_t pos = offset;
+    unsigned bl_off = 0;
+    for (auto [ext_off, ext_len] : m) {
+      if (ext_off > pos) {
+	*crc = ceph_crc32c(*crc, nullptr, ext_off - pos);
+      }
+      bufferlist t;
+      t.substr_of(bl, bl_off, ext_len);
+      *crc = t.crc32c(*crc);
+      bl_off += ext_len;
+      pos = ext_off + ext_len;
+    }
+    if (pos < offset + length) {
+      *crc = ceph_crc32c(*crc, nullptr, offset + length - pos);
+    }
+    r = length;
+  }
+
+ out:
+  if (r >= 0 && _debug_data_eio(oid)) {
+    r = -EIO;
+    derr << __func__ << " " << c->cid << " " << oid << " INJECT EIO" << dendl;
+  } else if (oid.hobj.pool > 0 &&  /* FIXME, see #23029 */
+	     cct->_conf->bluestore_debug_random_read_err &&
+	     (rand() % (int)(cct->_conf->bluestore_debug_random_read_err *
+			     100.0)) == 0) {
+    dout(0) << __func__ << ": inject random EIO" << dendl;
+    r = -EIO;
+  }
+  dout(10) << __func__ << " " << cid << " " << oid
+	   << " 0x" << std::hex << offset << "~" << length << std::dec
+	   << " = " << r << dendl;
+  log_latency(__func__,
+    l_bluestore_read_lat,
+    mono_clock::now() - start,
+    cct->_conf->bluestore_log_op_age);
+  return r;
+}
+
 int BlueStore::readv(
   CollectionHandle &c_,
   const ghobject_t& oid,
@@ -2817,6 +2817,8 @@ private:
     uint32_t op_flags = 0,
     uint64_t retry_count = 0);
 
+  void _fiemap_onode(OnodeRef o, uint64_t offset, size_t len,
+		     interval_set<uint64_t>& destset);
   int _fiemap(CollectionHandle &c_, const ghobject_t& oid,
 	      uint64_t offset, size_t len, interval_set<uint64_t>& destset);
 public:
@@ -2825,6 +2827,14 @@ public:
   int fiemap(CollectionHandle &c, const ghobject_t& oid,
 	     uint64_t offset, size_t len, std::map<uint64_t, uint64_t>& destmap) override;
 
+  int digest(
+    CollectionHandle &c,
+    const ghobject_t& oid,
+    uint64_t offset,
+    size_t len,
+    uint32_t *crc,
+    uint32_t op_flags = 0) override;
+
   int readv(
     CollectionHandle &c_,
     const ghobject_t& oid,
@@ -455,6 +455,7 @@ void ECBackend::handle_recovery_read_complete(
   for(map<pg_shard_t, bufferlist>::iterator i = to_read.get<2>().begin();
       i != to_read.get<2>().end();
       ++i) {
+    op.bytes_read += i->second.length();
     from[i->first.shard] = std::move(i->second);
   }
   dout(10) << __func__ << ": " << from << dendl;
@@ -621,6 +622,12 @@ void ECBackend::continue_recovery_op(
 	recovery_ops.erase(op.hoid);
 	return;
       }
+      if (is_subchunk_read(to_read, ec_impl->get_sub_chunk_count())) {
+	// e.g. clay: only the repair sub-chunks are fetched from the helpers
+	dout(20) << __func__ << ": reading repair sub-chunks " << to_read
+		 << dendl;
+	get_parent()->get_logger()->inc(l_osd_ec_recovery_subchunk_reads);
+      }
       m->read(
 	this,
 	op.hoid,
@@ -713,6 +720,8 @@ void ECBackend::continue_recovery_op(
 	  stat.num_objects_recovered = 1;
 	  if (get_parent()->pg_is_repair())
 	    stat.num_objects_repaired = 1;
+	  get_parent()->get_logger()->inc(
+	    l_osd_ec_recovery_read_bytes, op.bytes_read);
 	  get_parent()->on_global_recover(op.hoid, stat, false);
 	  dout(10) << __func__ << ": WRITING return " << op << dendl;
 	  recovery_ops.erase(op.hoid);
@@ -1649,6 +1658,37 @@ int ECBackend::get_min_avail_to_read_shards(
   return 0;
 }
 
+bool ECBackend::is_subchunk_read(
+  const map<pg_shard_t, vector<pair<int, int>>> &need,
+  int sub_chunk_count)
+{
+  for (auto &&i : need) {
+    if (i.second.size() != 1 ||
+	i.second.front().first != 0 ||
+	i.second.front().second != sub_chunk_count) {
+      return true;
+    }
+  }
+  return false;
+}
+
+uint64_t ECBackend::discard_subchunk_reads(
+  read_result_t &result,
+  set<int> *skip)
+{
+  uint64_t discarded = 0;
+  for (auto &&i : result.returned) {
+    for (auto &&j : i.get<2>()) {
+      discarded += j.second.length();
+    }
+    i.get<2>().clear();
+  }
+  for (auto &&i : result.errors) {
+    skip->insert(i.first.shard);
+  }
+  return discarded;
+}
+
 int ECBackend::get_remaining_shards(
   const hobject_t &hoid,
   const set<int> &avail,
@@ -2421,9 +2461,24 @@ int ECBackend::send_all_remaining_reads(
   ReadOp &rop)
 {
   set<int> already_read;
-  const set<pg_shard_t>& ots = rop.obj_to_source[hoid];
-  for (set<pg_shard_t>::iterator i = ots.begin(); i != ots.end(); ++i)
-    already_read.insert(i->shard);
+  if (is_subchunk_read(rop.to_read.find(hoid)->second.need,
+		       ec_impl->get_sub_chunk_count())) {
+    // The shards we got back only hold the repair sub-chunks, which are
+    // useless once the set of helpers changes.  Drop them and read whole
+    // chunks from every shard still needed, skipping only the failed ones.
+    uint64_t discarded =
+      discard_subchunk_reads(rop.complete[hoid], &already_read);
+    dout(10) << __func__ << " discarding " << discarded
+	     << " bytes of sub-chunk reads for " << hoid << dendl;
+    // they were read from the helpers all the same
+    if (auto op = recovery_ops.find(hoid); op != recovery_ops.end()) {
+      op->second.bytes_read += discarded;
+    }
+  } else {
+    const set<pg_shard_t>& ots = rop.obj_to_source[hoid];
+    for (set<pg_shard_t>::iterator i = ots.begin(); i != ots.end(); ++i)
+      already_read.insert(i->shard);
+  }
   dout(10) << __func__ << " have/error shards=" << already_read << dendl;
   map<pg_shard_t, vector<pair<int, int>>> shards;
   int r = get_remaining_shards(hoid, already_read, rop.want_to_read[hoid],
@@ -2518,13 +2573,13 @@ int ECBackend::be_deep_scrub(
   if (stride % sinfo.get_chunk_size())
     stride += sinfo.get_chunk_size() - (stride % sinfo.get_chunk_size());
 
-  bufferlist bl;
-  r = store->read(
+  uint32_t crc = pos.data_hash.digest();
+  r = store->digest(
     ch,
     ghobject_t(
       poid, ghobject_t::NO_GEN, get_parent()->whoami_shard().shard),
     pos.data_pos,
-    stride, bl,
+    stride, &crc,
     fadvise_flags);
   if (r < 0) {
     dout(20) << __func__ << "  " << poid << " got "
@@ -2532,7 +2587,7 @@ int ECBackend::be_deep_scrub(
     o.read_error = true;
     return 0;
   }
-  if (bl.length() % sinfo.get_chunk_size()) {
+  if (r % sinfo.get_chunk_size()) {
     dout(20) << __func__ << "  " << poid << " got "
 	     << r << " on read, not chunk size " << sinfo.get_chunk_size() << " aligned"
 	     << dendl;
@@ -2540,7 +2595,8 @@ int ECBackend::be_deep_scrub(
     return 0;
   }
   if (r > 0) {
-    pos.data_hash << bl;
+    pos.data_hash = bufferhash(crc);
+    get_parent()->get_logger()->inc(l_osd_scrub_deep_read_bytes, r);
   }
   pos.data_pos += r;
   if (r == (int)stride) {
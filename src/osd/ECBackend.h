@@ -283,6 +283,9 @@ private:
     // valid in state READING
     std::pair<uint64_t, uint64_t> extent_requested;
 
+    // bytes fetched from helper shards so far, for perf counters
+    uint64_t bytes_read = 0;
+
     void dump(ceph::Formatter *f) const;
 
     RecoveryOp() : state(IDLE) {}
@@ -651,6 +654,18 @@ public:
     std::map<pg_shard_t, std::vector<std::pair<int, int>>> *to_read   ///< [out] shards, corresponding subchunks to read
     ); ///< @return error code, 0 on success
 
+  /// true if need fetches less than whole chunks from some shard
+  static bool is_subchunk_read(
+    const std::map<pg_shard_t, std::vector<std::pair<int, int>>> &need,
+    int sub_chunk_count);
+
+  /// Drops the sub-chunk buffers returned so far, which cannot be mixed
+  /// with whole chunks read from other helpers, and adds the shards that
+  /// failed to skip.  @return bytes discarded
+  static uint64_t discard_subchunk_reads(
+    read_result_t &result,
+    std::set<int> *skip);
+
   int get_remaining_shards(
     const hobject_t &hoid,
     const std::set<int> &avail,
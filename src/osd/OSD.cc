@@ -724,6 +724,60 @@ void OSDService::promote_throttle_recalibrate()
   promote_max_bytes = target_bytes_sec * osd->OSD_TICK_INTERVAL * 2;
 }
 
+// static
+unsigned OSDService::step_latency_throttle(
+  unsigned level, unsigned max_level,
+  uint64_t ops, double lat, double target)
+{
+  if (target <= 0) {
+    return 0;
+  } else if (ops == 0) {
+    // idle, nothing to disturb
+    return level > 0 ? level - 1 : 0;
+  } else if (lat > target) {
+    return std::min(level + 1, max_level);
+  } else if (lat < target / 2 && level > 0) {
+    return level - 1;
+  }
+  return level;
+}
+
+void OSDService::client_latency_throttle_recalibrate()
+{
+  auto sample = logger->get_tavg_ns(l_osd_op_lat);
+  uint64_t ops = sample.second - last_op_lat_sample.second;
+  uint64_t ns = sample.first - last_op_lat_sample.first;
+  last_op_lat_sample = sample;
+  double lat = ops ? (double)ns / (double)ops / 1000000000.0 : 0;
+
+  double target = cct->_conf.get_val<double>("osd_scrub_latency_target");
+  uint64_t latency_pct = 0;
+  if (target > 0 && ops) {
+    latency_pct = lat * 100.0 / target;
+    dout(20) << __func__ << " " << ops << " ops, avg latency " << lat
+	     << " scrub target " << target << dendl;
+  }
+  unsigned level = step_latency_throttle(
+    scrub_throttle_level, SCRUB_THROTTLE_MAX_LEVEL, ops, lat, target);
+  if (level != scrub_throttle_level) {
+    dout(10) << __func__ << " scrub throttle level " << scrub_throttle_level
+	     << " -> " << level << dendl;
+    scrub_throttle_level = level;
+  }
+  logger->set(l_osd_scrub_throttle_level, level);
+  logger->set(l_osd_scrub_client_latency_pct, latency_pct);
+
+  target = cct->_conf.get_val<double>("osd_snap_trim_latency_target");
+  level = step_latency_throttle(
+    snap_trim_throttle_level, SNAP_TRIM_THROTTLE_MAX_LEVEL, ops, lat, target);
+  if (level != snap_trim_throttle_level) {
+    dout(10) << __func__ << " snap trim throttle level "
+	     << snap_trim_throttle_level << " -> " << level << dendl;
+    snap_trim_throttle_level = level;
+  }
+  logger->set(l_osd_snap_trim_throttle_level, level);
+}
+
 // -------------------------------------
 
 float OSDService::get_failsafe_full_ratio()
@@ -3269,14 +3323,19 @@ int OSD::get_recovery_max_active()
 
 float OSD::get_osd_snap_trim_sleep()
 {
+  // back off further while client latency is over budget
+  float throttle_sleep =
+    cct->_conf.get_val<double>("osd_snap_trim_adaptive_sleep_max") *
+    service.get_snap_trim_throttle_level() /
+    OSDService::SNAP_TRIM_THROTTLE_MAX_LEVEL;
   float osd_snap_trim_sleep = cct->_conf.get_val<double>("osd_snap_trim_sleep");
   if (osd_snap_trim_sleep > 0)
-    return osd_snap_trim_sleep;
+    return osd_snap_trim_sleep + throttle_sleep;
   if (!store_is_rotational && !journal_is_rotational)
-    return cct->_conf.get_val<double>("osd_snap_trim_sleep_ssd");
+    return cct->_conf.get_val<double>("osd_snap_trim_sleep_ssd") + throttle_sleep;
   if (store_is_rotational && !journal_is_rotational)
-    return cct->_conf.get_val<double>("osd_snap_trim_sleep_hybrid");
-  return cct->_conf.get_val<double>("osd_snap_trim_sleep_hdd");
+    return cct->_conf.get_val<double>("osd_snap_trim_sleep_hybrid") + throttle_sleep;
+  return cct->_conf.get_val<double>("osd_snap_trim_sleep_hdd") + throttle_sleep;
 }
 
 int OSD::init()
@@ -5906,6 +5965,7 @@ void OSD::tick_without_osd_lock()
       sched_scrub();
     }
     service.promote_throttle_recalibrate();
+    service.client_latency_throttle_recalibrate();
     resume_creating_pg();
     bool need_send_beacon = false;
     const auto now = ceph::coarse_mono_clock::now();
@@ -7349,13 +7409,17 @@ double OSD::scrub_sleep_time(bool must_scrub)
   if (must_scrub) {
     return cct->_conf->osd_scrub_sleep;
   }
+  // back off further while client latency is over budget
+  double throttle_sleep =
+    cct->_conf.get_val<double>("osd_scrub_adaptive_sleep_max") *
+    service.get_scrub_throttle_level() / OSDService::SCRUB_THROTTLE_MAX_LEVEL;
   utime_t now = ceph_clock_now();
   if (scrub_time_permit(now)) {
-    return cct->_conf->osd_scrub_sleep;
+    return cct->_conf->osd_scrub_sleep + throttle_sleep;
   }
   double normal_sleep = cct->_conf->osd_scrub_sleep;
   double extended_sleep = cct->_conf->osd_scrub_extended_sleep;
-  return std::max(extended_sleep, normal_sleep);
+  return std::max(extended_sleep, normal_sleep) + throttle_sleep;
 }
 
 bool OSD::scrub_time_permit(utime_t now)
@@ -278,6 +278,10 @@ private:
   ceph::mutex sched_scrub_lock = ceph::make_mutex("OSDService::sched_scrub_lock");
   int scrubs_local;
   int scrubs_remote;
+  /// adaptive scrub and snap trim throttles, driven by client op latency
+  std::atomic<unsigned> scrub_throttle_level{0};
+  std::atomic<unsigned> snap_trim_throttle_level{0};
+  std::pair<uint64_t, uint64_t> last_op_lat_sample; ///< (sum ns, count)
 
 public:
   struct ScrubJob {
@@ -359,6 +363,23 @@ public:
   void dec_scrubs_remote();
   void dump_scrub_reservations(ceph::Formatter *f);
 
+  static constexpr unsigned SCRUB_THROTTLE_MAX_LEVEL = 10;
+  static constexpr unsigned SNAP_TRIM_THROTTLE_MAX_LEVEL = 10;
+  /// next throttle level, given ops and their average latency (seconds)
+  /// over the last tick
+  static unsigned step_latency_throttle(
+    unsigned level, unsigned max_level,
+    uint64_t ops, double lat, double target);
+  void client_latency_throttle_recalibrate();
+  /// 0 when scrub may run at the configured pace
+  unsigned get_scrub_throttle_level() const {
+    return scrub_throttle_level;
+  }
+  /// 0 when snap trim may run at the configured pace
+  unsigned get_snap_trim_throttle_level() const {
+    return snap_trim_throttle_level;
+  }
+
   void reply_op_error(OpRequestRef op, int err);
   void reply_op_error(OpRequestRef op, int err, eversion_t v, version_t uv,
 		      std::vector<pg_log_op_return_item_t> op_returns);
@@ -22,6 +22,7 @@
 #include <boost/algorithm/string.hpp>
 
 #include "OSDMap.h"
+#include "OSDMapMapping.h"
 #include "common/config.h"
 #include "common/errno.h"
 #include "common/Formatter.h"
@@ -1573,7 +1574,7 @@ uint64_t OSDMap::get_features(int entity_type, uint64_t *pmask) const
   }
   mask |= CEPH_FEATURES_CRUSH;
 
-  if (!pg_upmap.empty() || !pg_upmap_items.empty())
+  if (!pg_upmap->empty() || !pg_upmap_items->empty())
     features |= CEPH_FEATUREMASK_OSDMAP_PG_UPMAP;
   mask |= CEPH_FEATUREMASK_OSDMAP_PG_UPMAP;
 
@@ -1758,6 +1759,19 @@ void OSDMap::dedup(const OSDMap *o, OSDMap *n)
   if (o->osd_uuid->size() == n->osd_uuid->size() &&
       *o->osd_uuid == *n->osd_uuid)
     n->osd_uuid = o->osd_uuid;
+
+  // does primary affinity match?
+  if (o->osd_primary_affinity && n->osd_primary_affinity &&
+      *o->osd_primary_affinity == *n->osd_primary_affinity)
+    n->osd_primary_affinity = o->osd_primary_affinity;
+
+  // do upmaps match?
+  if (o->pg_upmap->size() == n->pg_upmap->size() &&
+      *o->pg_upmap == *n->pg_upmap)
+    n->pg_upmap = o->pg_upmap;
+  if (o->pg_upmap_items->size() == n->pg_upmap_items->size() &&
+      *o->pg_upmap_items == *n->pg_upmap_items)
+    n->pg_upmap_items = o->pg_upmap_items;
 }
 
 void OSDMap::clean_temps(CephContext *cct,
@@ -1843,10 +1857,10 @@ void OSDMap::clean_temps(CephContext *cct,
 
 void OSDMap::get_upmap_pgs(vector<pg_t> *upmap_pgs) const
 {
-  upmap_pgs->reserve(pg_upmap.size() + pg_upmap_items.size());
-  for (auto& p : pg_upmap)
+  upmap_pgs->reserve(pg_upmap->size() + pg_upmap_items->size());
+  for (auto& p : *pg_upmap)
     upmap_pgs->push_back(p.first);
-  for (auto& p : pg_upmap_items)
+  for (auto& p : *pg_upmap_items)
     upmap_pgs->push_back(p.first);
 }
 
@@ -1926,16 +1940,16 @@ bool OSDMap::check_pg_upmaps(
       continue;
     // okay, upmap is valid
     // continue to check if it is still necessary
-    auto i = pg_upmap.find(pg);
-    if (i != pg_upmap.end() && raw == i->second) {
+    auto i = pg_upmap->find(pg);
+    if (i != pg_upmap->end() && raw == i->second) {
       ldout(cct, 10) << " removing redundant pg_upmap "
                      << i->first << " " << i->second
                      << dendl;
       to_cancel->push_back(pg);
       continue;
     }
-    auto j = pg_upmap_items.find(pg);
-    if (j != pg_upmap_items.end()) {
+    auto j = pg_upmap_items->find(pg);
+    if (j != pg_upmap_items->end()) {
       mempool::osdmap::vector<pair<int,int>> newmap;
       for (auto& p : j->second) {
         if (std::find(raw.begin(), raw.end(), p.first) == raw.end()) {
@@ -1983,8 +1997,8 @@ void OSDMap::clean_pg_upmaps(
                      << dendl;
       pending_inc->new_pg_upmap.erase(i);
     }
-    auto j = pg_upmap.find(pg);
-    if (j != pg_upmap.end()) {
+    auto j = pg_upmap->find(pg);
+    if (j != pg_upmap->end()) {
       ldout(cct, 10) << __func__ << " cancel invalid pg_upmap entry "
                      << j->first << "->" << j->second
                      << dendl;
@@ -1998,8 +2012,8 @@ void OSDMap::clean_pg_upmaps(
                      << dendl;
       pending_inc->new_pg_upmap_items.erase(p);
     }
-    auto q = pg_upmap_items.find(pg);
-    if (q != pg_upmap_items.end()) {
+    auto q = pg_upmap_items->find(pg);
+    if (q != pg_upmap_items->end()) {
       ldout(cct, 10) << __func__ << " cancel invalid "
                      << "pg_upmap_items entry "
                      << q->first << "->" << q->second
@@ -2223,16 +2237,16 @@ int OSDMap::apply_incremental(const Incremental &inc)
   }
 
   for (auto& p : inc.new_pg_upmap) {
-    pg_upmap[p.first] = p.second;
+    (*pg_upmap)[p.first] = p.second;
   }
   for (auto& pg : inc.old_pg_upmap) {
-    pg_upmap.erase(pg);
+    pg_upmap->erase(pg);
   }
   for (auto& p : inc.new_pg_upmap_items) {
-    pg_upmap_items[p.first] = p.second;
+    (*pg_upmap_items)[p.first] = p.second;
   }
   for (auto& pg : inc.old_pg_upmap_items) {
-    pg_upmap_items.erase(pg);
+    pg_upmap_items->erase(pg);
   }
 
   // blocklist
@@ -2322,6 +2336,70 @@ int OSDMap::apply_incremental(const Incremental &inc)
   return 0;
 }
 
+bool OSDMap::get_incremental_mapping_pgs(const Incremental& inc,
+					 const OSDMapMapping& mapping,
+					 std::set<pg_t> *pgs) const
+{
+  // anything that can move crush placement means a full recompute
+  if (inc.fullmap.length() ||
+      inc.crush.length() ||
+      inc.new_max_osd >= 0 ||
+      !inc.new_pools.empty() ||
+      !inc.old_pools.empty() ||
+      !inc.new_weight.empty() ||
+      !inc.new_up_client.empty()) {
+    return false;
+  }
+  if (mapping.get_num_pools() != pools.size()) {
+    return false;
+  }
+
+  // osds whose presence in a pg's up/acting set makes it suspect
+  std::set<int32_t> osds;
+  for (auto& [osd, s] : inc.new_state) {
+    uint32_t state = s ? s : CEPH_OSD_UP;
+    if (state & CEPH_OSD_EXISTS) {
+      return false;
+    }
+    if (state & CEPH_OSD_UP) {
+      if (is_up(osd)) {
+	// coming up may pull it into pgs that do not list it yet
+	return false;
+      }
+      osds.insert(osd);
+    }
+  }
+  for (auto& p : inc.new_primary_affinity) {
+    osds.insert(p.first);
+  }
+
+  auto add_pg = [&](pg_t pgid) {
+    if (mapping.has_pg(pgid)) {
+      pgs->insert(pgid);
+    }
+  };
+  for (auto& p : inc.new_pg_temp) {
+    add_pg(p.first);
+  }
+  for (auto& p : inc.new_primary_temp) {
+    add_pg(p.first);
+  }
+  for (auto& p : inc.new_pg_upmap) {
+    add_pg(p.first);
+  }
+  for (auto& pgid : inc.old_pg_upmap) {
+    add_pg(pgid);
+  }
+  for (auto& p : inc.new_pg_upmap_items) {
+    add_pg(p.first);
+  }
+  for (auto& pgid : inc.old_pg_upmap_items) {
+    add_pg(pgid);
+  }
+  mapping.get_pgs_with_osds(osds, pgs);
+  return true;
+}
+
 // mapping
 int OSDMap::map_to_pg(
   int64_t poolid,
@@ -2425,8 +2503,8 @@ int OSDMap::_pick_primary(const vector<int>& osds) const
 void OSDMap::_apply_upmap(const pg_pool_t& pi, pg_t raw_pg, vector<int> *raw) const
 {
   pg_t pg = pi.raw_pg_to_pg(raw_pg);
-  auto p = pg_upmap.find(pg);
-  if (p != pg_upmap.end()) {
+  auto p = pg_upmap->find(pg);
+  if (p != pg_upmap->end()) {
     // make sure targets aren't marked out
     for (auto osd : p->second) {
       if (osd != CRUSH_ITEM_NONE && osd < max_osd && osd >= 0 &&
@@ -2439,8 +2517,8 @@ void OSDMap::_apply_upmap(const pg_pool_t& pi, pg_t raw_pg, vector<int> *raw) co
     // continue to check and apply pg_upmap_items if any
   }
 
-  auto q = pg_upmap_items.find(pg);
-  if (q != pg_upmap_items.end()) {
+  auto q = pg_upmap_items->find(pg);
+  if (q != pg_upmap_items->end()) {
     // NOTE: this approach does not allow a bidirectional swap,
     // e.g., [[1,2],[2,1]] applied to [0,1,2] -> [0,2,1].
     for (auto& r : q->second) {
@@ -2962,11 +3040,11 @@ void OSDMap::encode(ceph::buffer::list& bl, uint64_t features) const
     encode(erasure_code_profiles, bl);
 
     if (v >= 4) {
-      encode(pg_upmap, bl);
-      encode(pg_upmap_items, bl);
+      encode(*pg_upmap, bl);
+      encode(*pg_upmap_items, bl);
     } else {
-      ceph_assert(pg_upmap.empty());
-      ceph_assert(pg_upmap_items.empty());
+      ceph_assert(pg_upmap->empty());
+      ceph_assert(pg_upmap_items->empty());
     }
     if (v >= 6) {
       encode(crush_version, bl);
@@ -3276,11 +3354,11 @@ void OSDMap::decode(ceph::buffer::list::const_iterator& bl)
     // version increased from 3 to 4 still in luminous, so same as above
     // applies.
     if (struct_v >= 4) {
-      decode(pg_upmap, bl);
-      decode(pg_upmap_items, bl);
+      decode(*pg_upmap, bl);
+      decode(*pg_upmap_items, bl);
     } else {
-      pg_upmap.clear();
-      pg_upmap_items.clear();
+      pg_upmap->clear();
+      pg_upmap_items->clear();
     }
     // again, version increased from 5 to 6 still in luminous, so above
     // applies.
@@ -3535,7 +3613,7 @@ void OSDMap::dump(Formatter *f) const
   f->close_section();
 
   f->open_array_section("pg_upmap");
-  for (auto& p : pg_upmap) {
+  for (auto& p : *pg_upmap) {
     f->open_object_section("mapping");
     f->dump_stream("pgid") << p.first;
     f->open_array_section("osds");
@@ -3547,7 +3625,7 @@ void OSDMap::dump(Formatter *f) const
   }
   f->close_section();
   f->open_array_section("pg_upmap_items");
-  for (auto& p : pg_upmap_items) {
+  for (auto& p : *pg_upmap_items) {
     f->open_object_section("mapping");
     f->dump_stream("pgid") << p.first;
     f->open_array_section("mappings");
@@ -3812,10 +3890,10 @@ void OSDMap::print(ostream& out) const
   print_osds(out);
   out << std::endl;
 
-  for (auto& p : pg_upmap) {
+  for (auto& p : *pg_upmap) {
     out << "pg_upmap " << p.first << " " << p.second << "\n";
   }
-  for (auto& p : pg_upmap_items) {
+  for (auto& p : *pg_upmap_items) {
     out << "pg_upmap_items " << p.first << " " << p.second << "\n";
   }
 
@@ -4756,8 +4834,8 @@ int OSDMap::calc_pg_upmaps(
       }
       // look for remaps we can un-remap
       for (auto pg : pgs) {
-	auto p = tmp.pg_upmap_items.find(pg);
-        if (p == tmp.pg_upmap_items.end())
+	auto p = tmp.pg_upmap_items->find(pg);
+        if (p == tmp.pg_upmap_items->end())
           continue;
         mempool::osdmap::vector<pair<int32_t,int32_t>> new_upmap_items;
         for (auto q : p->second) {
@@ -4796,8 +4874,8 @@ int OSDMap::calc_pg_upmaps(
 
       // try upmap
       for (auto pg : pgs) {
-        auto temp_it = tmp.pg_upmap.find(pg);
-        if (temp_it != tmp.pg_upmap.end()) {
+        auto temp_it = tmp.pg_upmap->find(pg);
+        if (temp_it != tmp.pg_upmap->end()) {
           // leave pg_upmap alone
           // it must be specified by admin since balancer does not
           // support pg_upmap yet
@@ -4809,14 +4887,14 @@ int OSDMap::calc_pg_upmaps(
         auto pg_pool_size = tmp.get_pg_pool_size(pg);
         mempool::osdmap::vector<pair<int32_t,int32_t>> new_upmap_items;
         set<int> existing;
-        auto it = tmp.pg_upmap_items.find(pg);
-        if (it != tmp.pg_upmap_items.end() &&
+        auto it = tmp.pg_upmap_items->find(pg);
+        if (it != tmp.pg_upmap_items->end() &&
             it->second.size() >= (size_t)pg_pool_size) {
           ldout(cct, 10) << " " << pg << " already has full-size pg_upmap_items "
                          << it->second << ", skipping"
                          << dendl;
           continue;
-        } else if (it != tmp.pg_upmap_items.end()) {
+        } else if (it != tmp.pg_upmap_items->end()) {
           ldout(cct, 10) << " " << pg << " already has pg_upmap_items "
                          << it->second
                          << dendl;
@@ -4899,8 +4977,8 @@ int OSDMap::calc_pg_upmaps(
       // look for remaps we can un-remap
       vector<pair<pg_t,
         mempool::osdmap::vector<pair<int32_t,int32_t>>>> candidates;
-      candidates.reserve(tmp.pg_upmap_items.size());
-      for (auto& i : tmp.pg_upmap_items) {
+      candidates.reserve(tmp.pg_upmap_items->size());
+      for (auto& i : *tmp.pg_upmap_items) {
         if (to_skip.count(i.first))
           continue;
         if (!only_pools.empty() && !only_pools.count(i.first.pool()))
@@ -5032,8 +5110,8 @@ int OSDMap::calc_pg_upmaps(
     deviation_osd = temp_deviation_osd;
     for (auto& i : to_unmap) {
       ldout(cct, 10) << " unmap pg " << i << dendl;
-      ceph_assert(tmp.pg_upmap_items.count(i));
-      tmp.pg_upmap_items.erase(i);
+      ceph_assert(tmp.pg_upmap_items->count(i));
+      tmp.pg_upmap_items->erase(i);
       pending_inc->old_pg_upmap_items.insert(i);
       ++num_changed;
     }
@@ -5041,7 +5119,7 @@ int OSDMap::calc_pg_upmaps(
       ldout(cct, 10) << " upmap pg " << i.first
                      << " new pg_upmap_items " << i.second
                      << dendl;
-      tmp.pg_upmap_items[i.first] = i.second;
+      (*tmp.pg_upmap_items)[i.first] = i.second;
       pending_inc->new_pg_upmap_items[i.first] = i.second;
       ++num_changed;
     }
@@ -43,6 +43,7 @@
 // forward declaration
 class CrushWrapper;
 class health_check_map_t;
+class OSDMapMapping;
 
 /*
  * we track up to two intervals during which the osd was alive and
@@ -565,8 +566,8 @@ private:
   std::shared_ptr< mempool::osdmap::vector<__u32> > osd_primary_affinity; ///< 16.16 fixed point, 0x10000 = baseline
 
   // remap (post-CRUSH, pre-up)
-  mempool::osdmap::map<pg_t,mempool::osdmap::vector<int32_t>> pg_upmap; ///< remap pg
-  mempool::osdmap::map<pg_t,mempool::osdmap::vector<std::pair<int32_t,int32_t>>> pg_upmap_items; ///< remap osds in up set
+  std::shared_ptr<mempool::osdmap::map<pg_t,mempool::osdmap::vector<int32_t>>> pg_upmap; ///< remap pg
+  std::shared_ptr<mempool::osdmap::map<pg_t,mempool::osdmap::vector<std::pair<int32_t,int32_t>>>> pg_upmap_items; ///< remap osds in up set
 
   mempool::osdmap::map<int64_t,pg_pool_t> pools;
   mempool::osdmap::map<int64_t,std::string> pool_name;
@@ -627,6 +628,8 @@ private:
 	     osd_addrs(std::make_shared<addrs_s>()),
 	     pg_temp(std::make_shared<PGTempMap>()),
 	     primary_temp(std::make_shared<mempool::osdmap::map<pg_t,int32_t>>()),
+	     pg_upmap(std::make_shared<mempool::osdmap::map<pg_t,mempool::osdmap::vector<int32_t>>>()),
+	     pg_upmap_items(std::make_shared<mempool::osdmap::map<pg_t,mempool::osdmap::vector<std::pair<int32_t,int32_t>>>>()),
 	     osd_uuid(std::make_shared<mempool::osdmap::vector<uuid_d>>()),
 	     cluster_snapshot_epoch(0),
 	     new_blocklist_entries(false),
@@ -651,6 +654,8 @@ public:
     *this = o;
     primary_temp.reset(new mempool::osdmap::map<pg_t,int32_t>(*o.primary_temp));
     pg_temp.reset(new PGTempMap(*o.pg_temp));
+    pg_upmap.reset(new mempool::osdmap::map<pg_t,mempool::osdmap::vector<int32_t>>(*o.pg_upmap));
+    pg_upmap_items.reset(new mempool::osdmap::map<pg_t,mempool::osdmap::vector<std::pair<int32_t,int32_t>>>(*o.pg_upmap_items));
     osd_uuid.reset(new mempool::osdmap::vector<uuid_d>(*o.osd_uuid));
 
     if (o.osd_primary_affinity)
@@ -1069,6 +1074,20 @@ public:
 
   int apply_incremental(const Incremental &inc);
 
+  /**
+   * collect the pgs whose mapping may change when inc is applied
+   *
+   * Called on the map inc was just applied to.  mapping must match the
+   * previous map, except for the pgs already in *pgs, so the result of
+   * several consecutive incrementals can be accumulated.  Returns false
+   * if inc changes placement too broadly (crush, pools, weights, osds
+   * coming up) to narrow it down, in which case everything needs to be
+   * recomputed.
+   */
+  bool get_incremental_mapping_pgs(const Incremental& inc,
+				   const OSDMapMapping& mapping,
+				   std::set<pg_t> *pgs) const;
+
   /// try to re-use/reference addrs in oldmap from newmap
   static void dedup(const OSDMap *oldmap, OSDMap *newmap);
 
@@ -1423,8 +1442,8 @@ public:
   int get_osds_by_bucket_name(const std::string &name, std::set<int> *osds) const;
 
   bool have_pg_upmaps(pg_t pg) const {
-    return pg_upmap.count(pg) ||
-      pg_upmap_items.count(pg);
+    return pg_upmap->count(pg) ||
+      pg_upmap_items->count(pg);
   }
 
   bool check_full(const std::set<pg_shard_t> &missing_on) const {
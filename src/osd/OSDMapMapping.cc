@@ -59,6 +59,56 @@ void OSDMapMapping::update(const OSDMap& osdmap, pg_t pgid)
   _update_range(osdmap, pgid.pool(), pgid.ps(), pgid.ps() + 1);
 }
 
+void OSDMapMapping::update(const OSDMap& osdmap, const std::set<pg_t>& pgs)
+{
+  _start(osdmap);
+  for (auto& pgid : pgs) {
+    _update_range(osdmap, pgid.pool(), pgid.ps(), pgid.ps() + 1);
+  }
+  _finish(osdmap);
+}
+
+void OSDMapMapping::get_pgs_with_osds(const std::set<int32_t>& osds,
+				      std::set<pg_t> *pgs) const
+{
+  if (osds.empty()) {
+    return;
+  }
+  for (auto& [poolid, pm] : pools) {
+    const size_t row_size = pm.row_size();
+    for (unsigned ps = 0; ps < pm.pg_num; ++ps) {
+      const int32_t *row = &pm.table[row_size * ps];
+      bool hit = false;
+      for (int i = 0; i < row[2] && !hit; ++i) {
+	hit = osds.count(row[4 + i]);
+      }
+      for (int i = 0; i < row[3] && !hit; ++i) {
+	hit = osds.count(row[4 + pm.size + i]);
+      }
+      if (hit) {
+	pgs->insert(pg_t(ps, poolid));
+      }
+    }
+  }
+}
+
+std::unique_ptr<OSDMapMapping::MappingJob> OSDMapMapping::start_update(
+  const OSDMap& map,
+  ParallelPGMapper& mapper,
+  unsigned pgs_per_item,
+  const std::set<pg_t>& pgs)
+{
+  std::unique_ptr<MappingJob> job(new MappingJob(&map, this));
+  if (pgs.empty()) {
+    // nothing moved; the job completes as soon as a finisher is set
+    epoch = map.get_epoch();
+  } else {
+    mapper.queue(job.get(), pgs_per_item,
+		 std::vector<pg_t>(pgs.begin(), pgs.end()));
+  }
+  return job;
+}
+
 void OSDMapMapping::_build_rmap(const OSDMap& osdmap)
 {
   acting_rmap.resize(osdmap.get_max_osd());
@@ -205,3 +255,131 @@ void ParallelPGMapper::queue(
   }
   ceph_assert(any);
 }
+
+// -------------------------
+
+void PGMovementPreview::compute(const OSDMap& from, const OSDMap& to,
+				ParallelPGMapper& mapper, unsigned pgs_per_item)
+{
+  moves.clear();
+  num_pgs = 0;
+  num_shards = 0;
+
+  OSDMapMapping from_mapping, to_mapping;
+  if (from.get_pools().empty() || to.get_pools().empty()) {
+    return;
+  }
+  auto from_job = from_mapping.start_update(from, mapper, pgs_per_item);
+  auto to_job = to_mapping.start_update(to, mapper, pgs_per_item);
+  from_job->wait();
+  to_job->wait();
+
+  for (auto& p : from.get_pools()) {
+    const pg_pool_t *to_pool = to.get_pg_pool(p.first);
+    if (!to_pool) {
+      continue;
+    }
+    unsigned data_shards = 1;
+    if (to_pool->is_erasure()) {
+      data_shards = to_pool->get_size();
+      auto& profile = to.get_erasure_code_profile(
+	to_pool->erasure_code_profile);
+      auto k = profile.find("k");
+      if (k != profile.end()) {
+	data_shards = std::max(1, atoi(k->second.c_str()));
+      }
+    }
+    unsigned pg_num = std::min(p.second.get_pg_num(), to_pool->get_pg_num());
+    for (unsigned ps = 0; ps < pg_num; ++ps) {
+      pg_t pgid(ps, p.first);
+      vector<int> before, after;
+      from_mapping.get(pgid, &before, nullptr, nullptr, nullptr);
+      to_mapping.get(pgid, &after, nullptr, nullptr, nullptr);
+      ++num_pgs;
+      if (before == after) {
+	continue;
+      }
+      unsigned shards = 0;
+      for (unsigned i = 0; i < after.size(); ++i) {
+	if (after[i] == CRUSH_ITEM_NONE) {
+	  continue;
+	}
+	if (to_pool->can_shift_osds()) {
+	  // replicated: any copy on an osd that didn't have one is new
+	  if (std::find(before.begin(), before.end(), after[i]) ==
+	      before.end()) {
+	    ++shards;
+	  }
+	} else if (i >= before.size() || before[i] != after[i]) {
+	  // erasure: each position holds a distinct shard
+	  ++shards;
+	}
+      }
+      auto& m = moves[pgid];
+      m.from.swap(before);
+      m.to.swap(after);
+      m.shards = shards;
+      m.data_shards = data_shards;
+      num_shards += shards;
+    }
+  }
+}
+
+uint64_t PGMovementPreview::estimate_bytes(
+  const std::map<pg_t,uint64_t>& pg_bytes,
+  uint64_t *unknown_pgs) const
+{
+  uint64_t bytes = 0;
+  uint64_t unknown = 0;
+  for (auto& [pgid, m] : moves) {
+    auto p = pg_bytes.find(pgid);
+    if (p == pg_bytes.end()) {
+      if (m.shards) {
+	++unknown;
+      }
+      continue;
+    }
+    bytes += p->second / m.data_shards * m.shards;
+  }
+  if (unknown_pgs) {
+    *unknown_pgs = unknown;
+  }
+  return bytes;
+}
+
+void PGMovementPreview::dump(ceph::Formatter *f,
+			     const std::map<pg_t,uint64_t> *pg_bytes) const
+{
+  f->dump_unsigned("num_pgs", num_pgs);
+  f->dump_unsigned("num_pgs_moved", moves.size());
+  f->dump_unsigned("num_shards_moved", num_shards);
+  if (pg_bytes) {
+    uint64_t unknown = 0;
+    f->dump_unsigned("bytes_moved", estimate_bytes(*pg_bytes, &unknown));
+    f->dump_unsigned("num_pgs_without_stats", unknown);
+  }
+  f->open_array_section("moves");
+  for (auto& [pgid, m] : moves) {
+    f->open_object_section("pg");
+    f->dump_stream("pgid") << pgid;
+    f->open_array_section("from");
+    for (auto osd : m.from) {
+      f->dump_int("osd", osd);
+    }
+    f->close_section();
+    f->open_array_section("to");
+    for (auto osd : m.to) {
+      f->dump_int("osd", osd);
+    }
+    f->close_section();
+    f->dump_unsigned("shards", m.shards);
+    if (pg_bytes) {
+      auto p = pg_bytes->find(pgid);
+      if (p != pg_bytes->end()) {
+	f->dump_unsigned("bytes", p->second / m.data_shards * m.shards);
+      }
+    }
+    f->close_section();
+  }
+  f->close_section();
+}
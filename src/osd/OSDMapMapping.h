@@ -7,6 +7,7 @@
 
 #include <vector>
 #include <map>
+#include <set>
 
 #include "osd/osd_types.h"
 #include "common/WorkQueue.h"
@@ -278,7 +279,11 @@ private:
       : Job(osdmap), mapping(m) {
       mapping->_start(*osdmap);
     }
-    void process(const std::vector<pg_t>& pgs) override {}
+    void process(const std::vector<pg_t>& pgs) override {
+      for (auto& pgid : pgs) {
+	mapping->_update_range(*osdmap, pgid.pool(), pgid.ps(), pgid.ps() + 1);
+      }
+    }
     void process(int64_t pool, unsigned ps_begin, unsigned ps_end) override {
       mapping->_update_range(*osdmap, pool, ps_begin, ps_end);
     }
@@ -328,6 +333,20 @@ public:
 
   void update(const OSDMap& map);
   void update(const OSDMap& map, pg_t pgid);
+  /// recompute only pgs, the rest are known not to have changed
+  void update(const OSDMap& map, const std::set<pg_t>& pgs);
+
+  /// true if the mapping has a row for pgid
+  bool has_pg(pg_t pgid) const {
+    auto p = pools.find(pgid.pool());
+    return p != pools.end() && pgid.ps() < p->second.pg_num;
+  }
+  size_t get_num_pools() const {
+    return pools.size();
+  }
+  /// add the pgs with any of osds in their up or acting set to *pgs
+  void get_pgs_with_osds(const std::set<int32_t>& osds,
+			 std::set<pg_t> *pgs) const;
 
   std::unique_ptr<MappingJob> start_update(
     const OSDMap& map,
@@ -337,6 +356,11 @@ public:
     mapper.queue(job.get(), pgs_per_item, {});
     return job;
   }
+  std::unique_ptr<MappingJob> start_update(
+    const OSDMap& map,
+    ParallelPGMapper& mapper,
+    unsigned pgs_per_item,
+    const std::set<pg_t>& pgs);
 
   epoch_t get_epoch() const {
     return epoch;
@@ -347,5 +371,35 @@ public:
   }
 };
 
+/// the pgs whose up set differs between two OSDMaps, e.g. before and
+/// after a proposed crush, weight or upmap change
+class PGMovementPreview {
+public:
+  struct pg_move_t {
+    std::vector<int> from, to;  ///< up sets
+    unsigned shards = 0;        ///< shards that have to be copied to a new osd
+    unsigned data_shards = 1;   ///< k for erasure pools, 1 for replicated
+  };
+
+  std::map<pg_t,pg_move_t> moves;
+  uint64_t num_pgs = 0;      ///< pgs present in both maps
+  uint64_t num_shards = 0;   ///< sum of moves[*].shards
+
+  /// map every pg with both maps on the mapper's threads and diff them
+  void compute(const OSDMap& from, const OSDMap& to,
+	       ParallelPGMapper& mapper, unsigned pgs_per_item);
+
+  /**
+   * estimate the bytes to copy, given each pg's size
+   *
+   * @param unknown_pgs [out] moved pgs with no entry in pg_bytes
+   */
+  uint64_t estimate_bytes(const std::map<pg_t,uint64_t>& pg_bytes,
+			  uint64_t *unknown_pgs) const;
+
+  void dump(ceph::Formatter *f,
+	    const std::map<pg_t,uint64_t> *pg_bytes = nullptr) const;
+};
+
 
 #endif
@@ -777,6 +777,7 @@ void PG::clear_recovery_state()
 
   backfill_info.clear();
   peer_backfill_info.clear();
+  peer_backfill_prefetch.clear();
   waiting_on_backfill.clear();
   _clear_recovery_state();  // pg impl specific hook
 }
@@ -2759,10 +2760,15 @@ void PG::chunky_scrub(ThreadPool::TPHandle &handle)
 	   * not exist (see _scrub).
 	   */
           ceph_assert(scrubber.preempt_divisor > 0);
+	  // smaller chunks hold off fewer client ops while we are throttled
+	  int divisor = scrubber.preempt_divisor;
+	  if (!scrubber.must_scrub) {
+	    divisor *= 1 + osd->get_scrub_throttle_level();
+	  }
 	  int min = std::max<int64_t>(3, cct->_conf->osd_scrub_chunk_min /
-				      scrubber.preempt_divisor);
+				      divisor);
 	  int max = std::max<int64_t>(min, cct->_conf->osd_scrub_chunk_max /
-                                      scrubber.preempt_divisor);
+                                      divisor);
           hobject_t start = scrubber.start;
 	  hobject_t candidate_end;
 	  vector<hobject_t> objects;
@@ -687,6 +687,8 @@ protected:
 protected:
   BackfillInterval backfill_info;
   std::map<pg_shard_t, BackfillInterval> peer_backfill_info;
+  /// next interval for each backfill target, scanned ahead of need
+  BackfillPrefetch peer_backfill_prefetch;
   bool backfill_reserving;
 
   // The primary's num_bytes and local num_bytes for this pg, only valid
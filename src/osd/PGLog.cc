@@ -806,6 +806,13 @@ void PGLog::_write_log_and_missing_wo_missing(
   }
 }
 
+/// smallest key sorting after k, for use as an exclusive range end
+static string key_after(string k)
+{
+  k.push_back('\0');
+  return k;
+}
+
 // static
 void PGLog::_write_log_and_missing(
   ObjectStore::Transaction& t,
@@ -828,20 +835,33 @@ void PGLog::_write_log_and_missing(
   set<string> *log_keys_debug
   ) {
   set<string> to_remove;
-  to_remove.swap(trimmed_dups);
-  for (auto& t : trimmed) {
-    string key = t.get_key_name();
-    if (log_keys_debug) {
-      auto it = log_keys_debug->find(key);
+  if (log_keys_debug) {
+    for (auto& t : trimmed) {
+      auto it = log_keys_debug->find(t.get_key_name());
       ceph_assert(it != log_keys_debug->end());
       log_keys_debug->erase(it);
     }
-    to_remove.emplace(std::move(key));
   }
-  trimmed.clear();
 
   if (touch_log)
     t.touch(coll, log_oid);
+  // trim() only ever drops entries and dups from the tail, so everything
+  // between the oldest and newest trimmed key is gone; remove the whole
+  // range in one op rather than one key at a time.
+  if (!trimmed.empty()) {
+    t.omap_rmkeyrange(
+      coll, log_oid,
+      trimmed.begin()->get_key_name(),
+      key_after(trimmed.rbegin()->get_key_name()));
+    trimmed.clear();
+  }
+  if (!trimmed_dups.empty()) {
+    t.omap_rmkeyrange(
+      coll, log_oid,
+      *trimmed_dups.begin(),
+      key_after(*trimmed_dups.rbegin()));
+    trimmed_dups.clear();
+  }
   if (dirty_to != eversion_t()) {
     t.omap_rmkeyrange(
       coll, log_oid,
@@ -141,6 +141,116 @@ struct PGLog : DoutPrefixProvider {
   using LogEntryHandlerRef = std::unique_ptr<LogEntryHandler>;
 
 public:
+  /**
+   * DupIndex - reqid -> dup lookup table
+   *
+   * A PG tracks osd_pg_log_dups_tracked dups (thousands) and every one of
+   * them used to cost a hash map node.  This is a flat open addressing
+   * table of pointers into pg_log_t::dups instead; the key is read back
+   * from the dup itself, so a slot is a single pointer.  Collisions are
+   * resolved by linear probing with backward shift deletion.
+   */
+  class DupIndex {
+    mempool::osd_pglog::vector<pg_log_dup_t*> slots;
+    size_t num_dups = 0;
+
+    static size_t hash(const osd_reqid_t &r) {
+      // std::hash<osd_reqid_t> just xors the fields; mix them properly as
+      // sequential tids from a single client would otherwise cluster
+      uint64_t h = r.name.num() ^ (r.tid << 1) ^ ((uint64_t)r.inc << 40) ^
+	r.name.type();
+      h ^= h >> 30;
+      h *= 0xbf58476d1ce4e5b9ull;
+      h ^= h >> 27;
+      h *= 0x94d049bb133111ebull;
+      h ^= h >> 31;
+      return h;
+    }
+    size_t mask() const {
+      return slots.size() - 1;
+    }
+    /// slot holding r, or the empty slot where r would go
+    size_t find_slot(const osd_reqid_t &r) const {
+      size_t i = hash(r) & mask();
+      while (slots[i] && slots[i]->reqid != r) {
+	i = (i + 1) & mask();
+      }
+      return i;
+    }
+    void rehash(size_t capacity) {
+      mempool::osd_pglog::vector<pg_log_dup_t*> old(capacity, nullptr);
+      old.swap(slots);
+      for (auto d : old) {
+	if (d) {
+	  slots[find_slot(d->reqid)] = d;
+	}
+      }
+    }
+
+  public:
+    size_t size() const {
+      return num_dups;
+    }
+    bool empty() const {
+      return num_dups == 0;
+    }
+    size_t count(const osd_reqid_t &r) const {
+      return find(r) ? 1 : 0;
+    }
+    pg_log_dup_t *find(const osd_reqid_t &r) const {
+      if (slots.empty()) {
+	return nullptr;
+      }
+      return slots[find_slot(r)];
+    }
+    /// keep the load factor <= 3/4 for n dups
+    void reserve(size_t n) {
+      size_t capacity = 16;
+      while (capacity * 3 < n * 4) {
+	capacity <<= 1;
+      }
+      if (capacity > slots.size()) {
+	rehash(capacity);
+      }
+    }
+    /// index d, replacing any dup with the same reqid
+    void insert(pg_log_dup_t *d) {
+      if ((num_dups + 1) * 4 > slots.size() * 3) {
+	reserve(num_dups + 1);
+      }
+      size_t i = find_slot(d->reqid);
+      if (!slots[i]) {
+	++num_dups;
+      }
+      slots[i] = d;
+    }
+    void erase(const osd_reqid_t &r) {
+      if (slots.empty()) {
+	return;
+      }
+      size_t i = find_slot(r);
+      if (!slots[i]) {
+	return;
+      }
+      slots[i] = nullptr;
+      --num_dups;
+      // pull back any following entry whose home slot is not in (i, j]
+      for (size_t j = (i + 1) & mask(); slots[j]; j = (j + 1) & mask()) {
+	size_t k = hash(slots[j]->reqid) & mask();
+	if (i <= j ? (i < k && k <= j) : (i < k || k <= j)) {
+	  continue;
+	}
+	slots[i] = slots[j];
+	slots[j] = nullptr;
+	i = j;
+      }
+    }
+    void clear() {
+      mempool::osd_pglog::vector<pg_log_dup_t*>().swap(slots);
+      num_dups = 0;
+    }
+  };
+
   /**
    * IndexLog - adds in-memory index of the log, by oid.
    * plus some methods to manipulate it all.
@@ -149,7 +259,7 @@ public:
     mutable ceph::unordered_map<hobject_t,pg_log_entry_t*> objects;  // ptrs into log.  be careful!
     mutable ceph::unordered_map<osd_reqid_t,pg_log_entry_t*> caller_ops;
     mutable ceph::unordered_multimap<osd_reqid_t,pg_log_entry_t*> extra_caller_ops;
-    mutable ceph::unordered_map<osd_reqid_t,pg_log_dup_t*> dup_index;
+    mutable DupIndex dup_index;
 
     // recovery pointers
     std::list<pg_log_entry_t>::iterator complete_to; // not inclusive of referenced item
@@ -389,12 +499,11 @@ public:
       if (!(indexed_data & PGLOG_INDEXED_DUPS)) {
         index_dups();
       }
-      auto q = dup_index.find(r);
-      if (q != dup_index.end()) {
-	*version = q->second->version;
-	*user_version = q->second->user_version;
-	*return_code = q->second->return_code;
-	*op_returns = q->second->op_returns;
+      if (auto q = dup_index.find(r); q) {
+	*version = q->version;
+	*user_version = q->user_version;
+	*return_code = q->return_code;
+	*op_returns = q->op_returns;
 	return true;
       }
 
@@ -458,8 +567,9 @@ public:
 	extra_caller_ops.clear();
       if (to_index & PGLOG_INDEXED_DUPS) {
 	dup_index.clear();
+	dup_index.reserve(dups.size());
 	for (auto& i : dups) {
-	  dup_index[i.reqid] = const_cast<pg_log_dup_t*>(&i);
+	  dup_index.insert(const_cast<pg_log_dup_t*>(&i));
 	}
       }
 
@@ -574,16 +684,13 @@ public:
 
     void index(pg_log_dup_t& e) {
       if (indexed_data & PGLOG_INDEXED_DUPS) {
-	dup_index[e.reqid] = &e;
+	dup_index.insert(&e);
       }
     }
 
     void unindex(const pg_log_dup_t& e) {
       if (indexed_data & PGLOG_INDEXED_DUPS) {
-	auto i = dup_index.find(e.reqid);
-	if (i != dup_index.end()) {
-	  dup_index.erase(i);
-	}
+	dup_index.erase(e.reqid);
       }
     }
 
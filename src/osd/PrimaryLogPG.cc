@@ -4270,7 +4270,16 @@ void PrimaryLogPG::do_scan(
       // Check that from is in backfill_targets vector
       ceph_assert(is_backfill_target(from));
 
-      BackfillInterval& bi = peer_backfill_info[from];
+      BackfillInterval *pf = peer_backfill_prefetch.on_reply(from, m->begin);
+      bool prefetched = pf != nullptr;
+      if (!prefetched && waiting_on_backfill.count(from) &&
+	  peer_backfill_info[from].end != m->begin) {
+	// the reply to a prefetch we discarded, not the scan we wait for
+	dout(10) << __func__ << " ignoring stale scan from " << from
+		 << " begin " << m->begin << dendl;
+	break;
+      }
+      BackfillInterval& bi = prefetched ? *pf : peer_backfill_info[from];
       bi.begin = m->begin;
       bi.end = m->end;
       auto p = m->get_data().cbegin();
@@ -4278,9 +4287,19 @@ void PrimaryLogPG::do_scan(
       // take care to preserve ordering!
       bi.clear_objects();
       decode_noclear(bi.objects, p);
-      dout(10) << __func__ << " bi.begin=" << bi.begin << " bi.end=" << bi.end
+      dout(10) << __func__ << (prefetched ? " prefetched" : "")
+	       << " bi.begin=" << bi.begin << " bi.end=" << bi.end
                << " bi.objects.size()=" << bi.objects.size() << dendl;
 
+      if (prefetched) {
+	if (!waiting_on_backfill.count(from)) {
+	  // recover_backfill will pick it up once the current one is used up
+	  break;
+	}
+	// recover_backfill already ran out and is waiting for this one
+	peer_backfill_info[from] = peer_backfill_prefetch.take(from);
+      }
+
       if (waiting_on_backfill.erase(from)) {
 	if (waiting_on_backfill.empty()) {
 	  ceph_assert(
@@ -13069,6 +13088,7 @@ uint64_t PrimaryLogPG::recover_backfill(
 
     backfills_in_flight.clear();
     pending_backfill_updates.clear();
+    peer_backfill_prefetch.clear();
   }
 
   for (set<pg_shard_t>::const_iterator i = get_backfill_targets().begin();
@@ -13123,6 +13143,28 @@ uint64_t PrimaryLogPG::recover_backfill(
       dout(20) << " peer shard " << bt << " backfill " << pbi << dendl;
       if (pbi.begin <= backfill_info.begin &&
 	  !pbi.extends_to_end() && pbi.empty()) {
+	if (peer_backfill_prefetch.has(bt) &&
+	    peer_backfill_prefetch.get_begin(bt) != pbi.end) {
+	  // not the continuation of this interval; scan again instead
+	  dout(10) << " discarding prefetched scan of peer osd." << bt
+		   << " from " << peer_backfill_prefetch.get_begin(bt) << dendl;
+	  peer_backfill_prefetch.discard(bt);
+	}
+	if (peer_backfill_prefetch.has(bt)) {
+	  if (peer_backfill_prefetch.is_pending(bt)) {
+	    dout(10) << " waiting for prefetched scan of peer osd." << bt
+		     << " from " << pbi.end << dendl;
+	    ceph_assert(waiting_on_backfill.find(bt) == waiting_on_backfill.end());
+	    waiting_on_backfill.insert(bt);
+	    sent_scan = true;
+	    continue;
+	  }
+	  pbi = peer_backfill_prefetch.take(bt);
+	  dout(10) << " using prefetched scan of peer osd." << bt
+		   << " " << pbi << dendl;
+	  if (!pbi.empty() || pbi.extends_to_end())
+	    continue;
+	}
 	dout(10) << " scanning peer osd." << bt << " from " << pbi.end << dendl;
 	epoch_t e = get_osdmap_epoch();
 	MOSDPGScan *m = new MOSDPGScan(
@@ -13143,6 +13185,26 @@ uint64_t PrimaryLogPG::recover_backfill(
       break;
     }
 
+    // Ask for the next interval while we work through this one.  The
+    // target does not see writes past last_backfill_started, which is
+    // below pbi.end, so the result stays valid until we get to it.
+    if (cct->_conf.get_val<bool>("osd_backfill_scan_prefetch")) {
+      for (const auto& bt : get_backfill_targets()) {
+	BackfillInterval& pbi = peer_backfill_info[bt];
+	if (pbi.empty() || pbi.extends_to_end() ||
+	    peer_backfill_prefetch.has(bt))
+	  continue;
+	dout(10) << " prefetching scan of peer osd." << bt
+		 << " from " << pbi.end << dendl;
+	peer_backfill_prefetch.start(bt, pbi.end);
+	MOSDPGScan *m = new MOSDPGScan(
+	  MOSDPGScan::OP_SCAN_GET_DIGEST, pg_whoami, get_osdmap_epoch(),
+	  get_last_peering_reset(), spg_t(info.pgid.pgid, bt.shard),
+	  pbi.end, hobject_t());
+	osd->send_message_osd_cluster(bt.osd, m, get_osdmap_epoch());
+      }
+    }
+
     if (backfill_info.empty() && all_peer_done()) {
       dout(10) << " reached end for both local and all peers" << dendl;
       break;
@@ -15365,6 +15427,12 @@ boost::statechart::result PrimaryLogPG::AwaitAsyncWork::react(const DoSnapWork&)
 
   vector<hobject_t> to_trim;
   unsigned max = pg->cct->_conf->osd_pg_max_concurrent_snap_trims;
+  // trim fewer objects at once while client latency is over budget
+  unsigned throttle = pg->osd->get_snap_trim_throttle_level();
+  max = std::max(
+    1u,
+    max * (OSDService::SNAP_TRIM_THROTTLE_MAX_LEVEL + 1 - throttle) /
+    (OSDService::SNAP_TRIM_THROTTLE_MAX_LEVEL + 1));
   to_trim.reserve(max);
   int r = pg->snap_mapper.get_next_objects_to_trim(
     snap_to_trim,
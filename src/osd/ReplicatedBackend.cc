@@ -19,6 +19,7 @@
 #include "messages/MOSDPGPush.h"
 #include "messages/MOSDPGPull.h"
 #include "messages/MOSDPGPushReply.h"
+#include "common/Checksummer.h"
 #include "common/EventTrace.h"
 #include "include/random.h"
 #include "include/util.h"
@@ -650,13 +651,13 @@ int ReplicatedBackend::be_deep_scrub(
       pos.data_hash = bufferhash(-1);
     }
 
-    bufferlist bl;
-    r = store->read(
+    uint32_t crc = pos.data_hash.digest();
+    r = store->digest(
       ch,
       ghobject_t(
 	poid, ghobject_t::NO_GEN, get_parent()->whoami_shard().shard),
       pos.data_pos,
-      cct->_conf->osd_deep_scrub_stride, bl,
+      cct->_conf->osd_deep_scrub_stride, &crc,
       fadvise_flags);
     if (r < 0) {
       dout(20) << __func__ << "  " << poid << " got "
@@ -665,7 +666,8 @@ int ReplicatedBackend::be_deep_scrub(
       return 0;
     }
     if (r > 0) {
-      pos.data_hash << bl;
+      pos.data_hash = bufferhash(crc);
+      get_parent()->get_logger()->inc(l_osd_scrub_deep_read_bytes, r);
     }
     pos.data_pos += r;
     if (r == cct->_conf->osd_deep_scrub_stride) {
@@ -1546,6 +1548,20 @@ int ReplicatedBackend::prep_push(ObjectContextRef obc,
 	    pop, cache_dont_need, ObcLockManager());
 }
 
+// static
+uint64_t ReplicatedBackend::partial_recovery_saved_bytes(
+  const ObjectRecoveryInfo &recovery_info)
+{
+  if (!recovery_info.object_exist ||
+      recovery_info.size == (uint64_t)-1 ||
+      recovery_info.size == 0)
+    return 0;
+  interval_set<uint64_t> pushed;
+  pushed.insert(0, recovery_info.size);
+  pushed.intersection_of(recovery_info.copy_subset);
+  return recovery_info.size - pushed.size();
+}
+
 int ReplicatedBackend::prep_push(
   ObjectContextRef obc,
   const hobject_t& soid, pg_shard_t peer,
@@ -1575,6 +1591,26 @@ int ReplicatedBackend::prep_push(
     HAVE_FEATURE(parent->min_peer_features(), SERVER_OCTOPUS);
   pi.lock_manager = std::move(lock_manager);
 
+  if (want_block_hashes(pi.recovery_info)) {
+    // find out what the target's copy already has first; the data push
+    // is built once its hashes are back, in handle_push_reply()
+    pi.block_hash_size = cct->_conf.get_val<Option::size_t>(
+      "osd_recovery_block_hash_size");
+    dout(10) << __func__ << " " << soid << " asking osd." << peer
+	     << " for block hashes of " << pi.recovery_info.copy_subset
+	     << dendl;
+    pop->soid = soid;
+    pop->version = version;
+    pop->recovery_info = pi.recovery_info;
+    pop->before_progress = pi.recovery_progress;
+    pop->after_progress = pi.recovery_progress;
+    pop->block_hash_size = pi.block_hash_size;
+    return 0;
+  }
+  get_parent()->get_logger()->inc(
+    l_osd_recovery_bytes_saved,
+    partial_recovery_saved_bytes(pi.recovery_info));
+
   ObjectRecoveryProgress new_progress;
   int r = build_push_op(pi.recovery_info,
 			pi.recovery_progress,
@@ -1587,6 +1623,135 @@ int ReplicatedBackend::prep_push(
   return 0;
 }
 
+bool ReplicatedBackend::want_block_hashes(
+  const ObjectRecoveryInfo &recovery_info) const
+{
+  uint64_t block_size = cct->_conf.get_val<Option::size_t>(
+    "osd_recovery_block_hash_size");
+  if (!block_size ||
+      !recovery_info.object_exist ||
+      !HAVE_FEATURE(parent->min_peer_features(), OSD_RECOVERY_BLOCK_HASHES))
+    return false;
+  // each side hashes its copy with a single read, and the round trip is
+  // only worth it if there is enough to push
+  uint64_t min_size = std::max<uint64_t>(
+    block_size,
+    cct->_conf.get_val<Option::size_t>("osd_recovery_block_hash_min_size"));
+  return recovery_info.size <= cct->_conf->osd_recovery_max_chunk &&
+    recovery_info.copy_subset.size() >= min_size;
+}
+
+// static
+void ReplicatedBackend::calc_block_hashes(
+  const bufferlist &data,
+  uint32_t block_size,
+  vector<uint64_t> *hashes)
+{
+  hashes->clear();
+  size_t blocks = data.length() / block_size;
+  if (!blocks)
+    return;
+  bufferptr csum_data = buffer::create(
+    blocks * sizeof(Checksummer::xxhash64::value_t));
+  Checksummer::calculate<Checksummer::xxhash64>(
+    block_size, 0, blocks * block_size, data, &csum_data);
+  auto p = reinterpret_cast<const Checksummer::xxhash64::value_t*>(
+    csum_data.c_str());
+  hashes->assign(p, p + blocks);
+}
+
+// static
+uint64_t ReplicatedBackend::skip_matching_blocks(
+  uint32_t block_size,
+  const vector<uint64_t> &ours,
+  const vector<uint64_t> &theirs,
+  interval_set<uint64_t> *copy_subset)
+{
+  interval_set<uint64_t> same;
+  for (size_t i = 0; i < std::min(ours.size(), theirs.size()); ++i) {
+    if (ours[i] == theirs[i])
+      same.insert(i * block_size, block_size);
+  }
+  same.intersection_of(*copy_subset);
+  copy_subset->subtract(same);
+  return same.size();
+}
+
+int ReplicatedBackend::apply_block_hashes(
+  PushInfo *pi,
+  const vector<uint64_t> &theirs)
+{
+  ObjectRecoveryInfo &recovery_info = pi->recovery_info;
+  uint32_t block_size = std::exchange(pi->block_hash_size, 0);
+  if (theirs.empty()) {
+    dout(10) << __func__ << " " << recovery_info.soid
+	     << " target has nothing to reuse, pushing "
+	     << recovery_info.copy_subset << dendl;
+    return 0;
+  }
+
+  // read all of it, so the data digest is checked as a full push would
+  bufferlist bl;
+  int r = store->read(ch, ghobject_t(recovery_info.soid), 0,
+		      recovery_info.size, bl,
+		      CEPH_OSD_OP_FLAG_FADVISE_SEQUENTIAL);
+  if (r < 0)
+    return r;
+  if (bl.length() == recovery_info.oi.size &&
+      recovery_info.oi.is_data_digest()) {
+    uint32_t crc = bl.crc32c(-1);
+    if (recovery_info.oi.data_digest != crc) {
+      dout(0) << __func__ << " " << coll << std::hex
+	      << " full-object read crc 0x" << crc
+	      << " != expected 0x" << recovery_info.oi.data_digest
+	      << std::dec << " on " << recovery_info.soid << dendl;
+      return -EIO;
+    }
+  }
+
+  vector<uint64_t> ours;
+  calc_block_hashes(bl, block_size, &ours);
+  uint64_t saved = skip_matching_blocks(block_size, ours, theirs,
+					&recovery_info.copy_subset);
+  dout(10) << __func__ << " " << recovery_info.soid << " " << saved
+	   << " bytes match the target, pushing "
+	   << recovery_info.copy_subset << dendl;
+  get_parent()->get_logger()->inc(l_osd_recovery_block_hash_bytes_saved,
+				  saved);
+  return 0;
+}
+
+void ReplicatedBackend::handle_block_hash_request(
+  const PushOp &pop, PushReplyOp *response)
+{
+  const ObjectRecoveryInfo &recovery_info = pop.recovery_info;
+  response->soid = recovery_info.soid;
+  if (recovery_info.copy_subset.empty())
+    return;
+
+  // only blocks below both the new size and the end of the push can be
+  // skipped by the primary
+  struct stat st;
+  int r = store->stat(ch, ghobject_t(recovery_info.soid), &st);
+  if (r == 0) {
+    uint64_t len = std::min({recovery_info.size,
+			     recovery_info.copy_subset.range_end(),
+			     (uint64_t)st.st_size});
+    len -= len % pop.block_hash_size;
+    if (len) {
+      bufferlist bl;
+      r = store->read(ch, ghobject_t(recovery_info.soid), 0, len, bl,
+		      CEPH_OSD_OP_FLAG_FADVISE_SEQUENTIAL |
+		      CEPH_OSD_OP_FLAG_FADVISE_DONTNEED);
+      if (r >= 0)
+	calc_block_hashes(bl, pop.block_hash_size, &response->block_hashes);
+    }
+  }
+  dout(10) << __func__ << " " << recovery_info.soid << " "
+	   << response->block_hashes.size() << " block hashes, r = " << r
+	   << dendl;
+}
+
 void ReplicatedBackend::submit_push_data(
   const ObjectRecoveryInfo &recovery_info,
   bool first,
@@ -1806,6 +1971,9 @@ bool ReplicatedBackend::handle_pull_response(
     pi.recovery_info.size = pop.recovery_info.size;
     pi.recovery_info.copy_subset.intersection_of(
       pop.recovery_info.copy_subset);
+    get_parent()->get_logger()->inc(
+      l_osd_recovery_bytes_saved,
+      partial_recovery_saved_bytes(pi.recovery_info));
   }
   // If primary doesn't have object info and didn't know version
   if (pi.recovery_info.version == eversion_t()) {
@@ -1907,6 +2075,10 @@ void ReplicatedBackend::handle_push(
 	   << pop.recovery_info
 	   << pop.after_progress
 	   << dendl;
+  if (pop.block_hash_size) {
+    handle_block_hash_request(pop, response);
+    return;
+  }
   bufferlist data;
   data = pop.data;
   bool first = pop.before_progress.first;
@@ -2009,6 +2181,24 @@ void ReplicatedBackend::send_pulls(int prio, map<pg_shard_t, vector<PullOp> > &p
   }
 }
 
+// static
+int ReplicatedBackend::read_push_omap_header(
+  ObjectStore *store,
+  ObjectStore::CollectionHandle &ch,
+  const hobject_t &soid,
+  const object_info_t &oi,
+  PushOp *out_op,
+  ObjectRecoveryProgress *progress)
+{
+  if (!oi.is_omap()) {
+    // most small (e.g. rgw data) objects have no omap at all; don't pay
+    // for an omap header lookup and iterator per object
+    progress->omap_complete = true;
+    return 0;
+  }
+  return store->omap_get_header(ch, ghobject_t(soid), &out_op->omap_header);
+}
+
 int ReplicatedBackend::build_push_op(const ObjectRecoveryInfo &recovery_info,
 				     const ObjectRecoveryProgress &progress,
 				     ObjectRecoveryProgress *out_progress,
@@ -2031,12 +2221,7 @@ int ReplicatedBackend::build_push_op(const ObjectRecoveryInfo &recovery_info,
   eversion_t v  = recovery_info.version;
   object_info_t oi;
   if (progress.first) {
-    int r = store->omap_get_header(ch, ghobject_t(recovery_info.soid), &out_op->omap_header);
-    if(r < 0) {
-      dout(1) << __func__ << " get omap header failed: " << cpp_strerror(-r) << dendl; 
-      return r;
-    }
-    r = store->getattrs(ch, ghobject_t(recovery_info.soid), out_op->attrset);
+    int r = store->getattrs(ch, ghobject_t(recovery_info.soid), out_op->attrset);
     if(r < 0) {
       dout(1) << __func__ << " getattrs failed: " << cpp_strerror(-r) << dendl;
       return r;
@@ -2064,6 +2249,17 @@ int ReplicatedBackend::build_push_op(const ObjectRecoveryInfo &recovery_info,
       return -EINVAL;
     }
 
+    r = read_push_omap_header(store, ch, recovery_info.soid, oi, out_op,
+			      &new_progress);
+    if(r < 0) {
+      dout(1) << __func__ << " get omap header failed: " << cpp_strerror(-r) << dendl;
+      return r;
+    }
+    if (!oi.is_omap()) {
+      dout(20) << __func__ << " " << recovery_info.soid << " has no omap"
+	       << dendl;
+    }
+
     new_progress.first = false;
   }
   // Once we provide the version subsequent requests will have it, so
@@ -2071,7 +2267,7 @@ int ReplicatedBackend::build_push_op(const ObjectRecoveryInfo &recovery_info,
   ceph_assert(v != eversion_t());
 
   uint64_t available = cct->_conf->osd_recovery_max_chunk;
-  if (!progress.omap_complete) {
+  if (!new_progress.omap_complete) {
     ObjectMap::ObjectMapIterator iter =
       store->get_omap_iterator(ch,
 			       ghobject_t(recovery_info.soid));
@@ -2209,6 +2405,17 @@ bool ReplicatedBackend::handle_push_reply(
     PushInfo *pi = &pushing[soid][peer];
     bool error = pushing[soid].begin()->second.recovery_progress.error;
 
+    if (pi->block_hash_size && !error) {
+      int r = apply_block_hashes(pi, op.block_hashes);
+      if (r < 0) {
+        dout(5) << __func__ << ": oid " << soid << " error " << r << dendl;
+	error = true;
+	goto done;
+      }
+      get_parent()->get_logger()->inc(
+	l_osd_recovery_bytes_saved,
+	partial_recovery_saved_bytes(pi->recovery_info));
+    }
     if (!pi->recovery_progress.data_complete && !error) {
       dout(10) << " pushing more from, "
 	       << pi->recovery_progress.data_recovered_to
@@ -162,6 +162,36 @@ public:
                Context *on_complete,
                bool fast_read = false) override;
 
+  /// bytes of an object a push need not send because the target already
+  /// holds them (clean regions or clone overlap)
+  static uint64_t partial_recovery_saved_bytes(
+    const ObjectRecoveryInfo &recovery_info);
+
+  /// hashes each full block_size block of data, for comparing the
+  /// primary's copy of an object with a push target's
+  static void calc_block_hashes(
+    const ceph::buffer::list &data,
+    uint32_t block_size,
+    std::vector<uint64_t> *hashes);
+
+  /// drops the blocks whose hashes match the target's from copy_subset,
+  /// returns how many bytes that saves
+  static uint64_t skip_matching_blocks(
+    uint32_t block_size,
+    const std::vector<uint64_t> &ours,
+    const std::vector<uint64_t> &theirs,
+    interval_set<uint64_t> *copy_subset);
+
+  /// reads the omap header of an object to push into out_op; if oi says
+  /// the object has no omap, marks omap recovery complete instead
+  static int read_push_omap_header(
+    ObjectStore *store,
+    ObjectStore::CollectionHandle &ch,
+    const hobject_t &soid,
+    const object_info_t &oi,
+    PushOp *out_op,
+    ObjectRecoveryProgress *progress);
+
 private:
   // push
   struct PushInfo {
@@ -170,6 +200,7 @@ private:
     ObjectContextRef obc;
     object_stat_sum_t stat;
     ObcLockManager lock_manager;
+    uint32_t block_hash_size = 0; ///< waiting for the target's block hashes
 
     void dump(ceph::Formatter *f) const {
       {
@@ -239,6 +270,9 @@ private:
   void do_push_reply(OpRequestRef op);
 
   bool handle_push_reply(pg_shard_t peer, const PushReplyOp &op, PushOp *reply);
+  bool want_block_hashes(const ObjectRecoveryInfo &recovery_info) const;
+  int apply_block_hashes(PushInfo *pi, const std::vector<uint64_t> &theirs);
+  void handle_block_hash_request(const PushOp &pop, PushReplyOp *response);
   void handle_pull(pg_shard_t peer, PullOp &op, PushOp *reply);
 
   struct pull_complete_info {
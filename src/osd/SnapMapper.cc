@@ -322,12 +322,22 @@ int SnapMapper::get_next_objects_to_trim(
 {
   ceph_assert(out);
   ceph_assert(out->empty());
+  if (trim_resume_snap != snap) {
+    trim_resume_snap = snap;
+    trim_resume_key.clear();
+  }
+  const bool resumed = !trim_resume_key.empty();
   int r = 0;
   for (set<string>::iterator i = prefixes.begin();
        i != prefixes.end() && out->size() < max && r == 0;
        ++i) {
     string prefix(get_prefix(pool, snap) + *i);
     string pos = prefix;
+    if (trim_resume_key > prefix) {
+      if (trim_resume_key.compare(0, prefix.size(), prefix) != 0)
+	continue; // resume point is past everything under this prefix
+      pos = trim_resume_key;
+    }
     while (out->size() < max) {
       pair<string, bufferlist> next;
       r = backend.get_next(pos, &next);
@@ -351,9 +361,16 @@ int SnapMapper::get_next_objects_to_trim(
 
       out->push_back(next_decoded.second);
       pos = next.first;
+      trim_resume_key = pos;
     }
   }
   if (out->size() == 0) {
+    trim_resume_key.clear();
+    if (resumed) {
+      dout(20) << __func__ << " rescanning snap " << snap
+	       << " from the start" << dendl;
+      return get_next_objects_to_trim(snap, max, out);
+    }
     return -ENOENT;
   } else {
     return 0;
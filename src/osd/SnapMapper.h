@@ -261,6 +261,9 @@ public:
   uint32_t mask_bits;
   const uint32_t match;
   std::string last_key_checked;
+  /// snap and last mapping key returned by get_next_objects_to_trim
+  snapid_t trim_resume_snap = CEPH_NOSNAP;
+  std::string trim_resume_key;
   const int64_t pool;
   const shard_id_t shard;
   const std::string shard_prefix;
@@ -308,7 +311,14 @@ public:
     MapCacher::Transaction<std::string, ceph::buffer::list> *t ///< [out] transaction
     );
 
-  /// Returns first object with snap as a snap
+  /**
+   * Returns first objects with snap as a snap
+   *
+   * Successive calls for the same snap resume after the last mapping
+   * returned rather than walking the removed keys in front of it again.
+   * Once that runs dry the whole prefix is rescanned once, so objects
+   * the caller skipped are still returned before -ENOENT.
+   */
   int get_next_objects_to_trim(
     snapid_t snap,              ///< [in] snap to check
     unsigned max,               ///< [in] max to get
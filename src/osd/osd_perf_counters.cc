@@ -161,6 +161,21 @@ PerfCounters *build_osd_logger(CephContext *cct) {
    l_osd_rbytes, "recovery_bytes",
    "recovery bytes",
    "rbt", PerfCountersBuilder::PRIO_INTERESTING);
+  osd_plb.add_u64_counter(
+    l_osd_recovery_bytes_saved, "recovery_bytes_saved",
+    "Object data not sent during recovery because the target already had it",
+    NULL, 0, unit_t(UNIT_BYTES));
+  osd_plb.add_u64_counter(
+    l_osd_recovery_block_hash_bytes_saved, "recovery_block_hash_bytes_saved",
+    "Part of recovery_bytes_saved found by comparing block hashes with the target",
+    NULL, 0, unit_t(UNIT_BYTES));
+  osd_plb.add_u64_avg(
+    l_osd_ec_recovery_read_bytes, "ec_recovery_read_bytes",
+    "Bytes read from helper shards per recovered erasure coded object",
+    NULL, 0, unit_t(UNIT_BYTES));
+  osd_plb.add_u64_counter(
+    l_osd_ec_recovery_subchunk_reads, "ec_recovery_subchunk_reads",
+    "Erasure coded recovery reads fetching only repair sub-chunks");
 
   osd_plb.add_u64(l_osd_loadavg, "loadavg", "CPU load");
   osd_plb.add_u64(
@@ -278,6 +293,20 @@ PerfCounters *build_osd_logger(CephContext *cct) {
   osd_plb.add_u64_counter(
     l_osd_pg_biginfo, "osd_pg_biginfo", "PG updated its biginfo attr");
 
+  osd_plb.add_u64_counter(
+    l_osd_scrub_deep_read_bytes, "scrub_deep_read_bytes",
+    "Object data read by deep scrub", NULL, 0, unit_t(UNIT_BYTES));
+  osd_plb.add_u64(
+    l_osd_scrub_throttle_level, "scrub_throttle_level",
+    "Adaptive scrub throttle level (0 = unthrottled)");
+  osd_plb.add_u64(
+    l_osd_scrub_client_latency_pct, "scrub_client_latency_pct",
+    "Client op latency as a percentage of osd_scrub_latency_target");
+
+  osd_plb.add_u64(
+    l_osd_snap_trim_throttle_level, "snap_trim_throttle_level",
+    "Adaptive snap trim throttle level (0 = unthrottled)");
+
   return osd_plb.create_perf_counters();
 }
  
@@ -57,6 +57,10 @@ enum {
 
   l_osd_rop,
   l_osd_rbytes,
+  l_osd_recovery_bytes_saved,
+  l_osd_recovery_block_hash_bytes_saved,
+  l_osd_ec_recovery_read_bytes,
+  l_osd_ec_recovery_subchunk_reads,
 
   l_osd_loadavg,
   l_osd_cached_crc,
@@ -118,6 +122,12 @@ enum {
   l_osd_pg_fastinfo,
   l_osd_pg_biginfo,
 
+  l_osd_scrub_deep_read_bytes,
+  l_osd_scrub_throttle_level,
+  l_osd_scrub_client_latency_pct,
+
+  l_osd_snap_trim_throttle_level,
+
   l_osd_last,
 };
 
@@ -6384,32 +6384,42 @@ void PushReplyOp::generate_test_instances(list<PushReplyOp*> &o)
   o.back()->soid = hobject_t(sobject_t("asdf", 2));
   o.push_back(new PushReplyOp);
   o.back()->soid = hobject_t(sobject_t("asdf", CEPH_NOSNAP));
+  o.push_back(new PushReplyOp);
+  o.back()->soid = hobject_t(sobject_t("asdf", CEPH_NOSNAP));
+  o.back()->block_hashes = {1, 2, 3};
 }
 
 void PushReplyOp::encode(ceph::buffer::list &bl) const
 {
-  ENCODE_START(1, 1, bl);
+  ENCODE_START(2, 1, bl);
   encode(soid, bl);
+  encode(block_hashes, bl);
   ENCODE_FINISH(bl);
 }
 
 void PushReplyOp::decode(ceph::buffer::list::const_iterator &bl)
 {
-  DECODE_START(1, bl);
+  DECODE_START(2, bl);
   decode(soid, bl);
+  if (struct_v >= 2) {
+    decode(block_hashes, bl);
+  }
   DECODE_FINISH(bl);
 }
 
 void PushReplyOp::dump(Formatter *f) const
 {
   f->dump_stream("soid") << soid;
+  f->dump_unsigned("num_block_hashes", block_hashes.size());
 }
 
 ostream &PushReplyOp::print(ostream &out) const
 {
-  return out
-    << "PushReplyOp(" << soid
-    << ")";
+  out << "PushReplyOp(" << soid;
+  if (!block_hashes.empty()) {
+    out << ", block_hashes: " << block_hashes.size();
+  }
+  return out << ")";
 }
 
 ostream& operator<<(ostream& out, const PushReplyOp &op)
@@ -6499,11 +6509,15 @@ void PushOp::generate_test_instances(list<PushOp*> &o)
   o.push_back(new PushOp);
   o.back()->soid = hobject_t(sobject_t("asdf", CEPH_NOSNAP));
   o.back()->version = eversion_t(0, 0);
+  o.push_back(new PushOp);
+  o.back()->soid = hobject_t(sobject_t("asdf", CEPH_NOSNAP));
+  o.back()->version = eversion_t(3, 10);
+  o.back()->block_hash_size = 65536;
 }
 
 void PushOp::encode(ceph::buffer::list &bl, uint64_t features) const
 {
-  ENCODE_START(1, 1, bl);
+  ENCODE_START(2, 1, bl);
   encode(soid, bl);
   encode(version, bl);
   encode(data, bl);
@@ -6514,12 +6528,13 @@ void PushOp::encode(ceph::buffer::list &bl, uint64_t features) const
   encode(recovery_info, bl, features);
   encode(after_progress, bl);
   encode(before_progress, bl);
+  encode(block_hash_size, bl);
   ENCODE_FINISH(bl);
 }
 
 void PushOp::decode(ceph::buffer::list::const_iterator &bl)
 {
-  DECODE_START(1, bl);
+  DECODE_START(2, bl);
   decode(soid, bl);
   decode(version, bl);
   decode(data, bl);
@@ -6530,6 +6545,9 @@ void PushOp::decode(ceph::buffer::list::const_iterator &bl)
   decode(recovery_info, bl);
   decode(after_progress, bl);
   decode(before_progress, bl);
+  if (struct_v >= 2) {
+    decode(block_hash_size, bl);
+  }
   DECODE_FINISH(bl);
 }
 
@@ -6557,10 +6575,19 @@ void PushOp::dump(Formatter *f) const
     before_progress.dump(f);
     f->close_section();
   }
+  f->dump_unsigned("block_hash_size", block_hash_size);
 }
 
 ostream &PushOp::print(ostream &out) const
 {
+  if (block_hash_size) {
+    return out
+      << "PushOp(" << soid
+      << ", version: " << version
+      << ", block_hash_size: " << block_hash_size
+      << ", recovery_info: " << recovery_info
+      << ")";
+  }
   return out
     << "PushOp(" << soid
     << ", version: " << version
@@ -5827,6 +5827,9 @@ std::ostream& operator<<(std::ostream& out, const ObjectRecoveryProgress &prog);
 
 struct PushReplyOp {
   hobject_t soid;
+  /// answer to PushOp::block_hash_size: hashes of the full blocks of the
+  /// target's copy, empty if it has none to offer
+  std::vector<uint64_t> block_hashes;
 
   static void generate_test_instances(std::list<PushReplyOp*>& o);
   void encode(ceph::buffer::list &bl) const;
@@ -5869,6 +5872,10 @@ struct PushOp {
   ObjectRecoveryProgress before_progress;
   ObjectRecoveryProgress after_progress;
 
+  /// if set, carries no data: asks the target for the hashes of the
+  /// blocks of this size in its copy of copy_subset
+  uint32_t block_hash_size = 0;
+
   static void generate_test_instances(std::list<PushOp*>& o);
   void encode(ceph::buffer::list &bl, uint64_t features) const;
   void decode(ceph::buffer::list::const_iterator &bl);
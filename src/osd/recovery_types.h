@@ -4,6 +4,7 @@
 #pragma once
 
 #include <map>
+#include <set>
 
 #include "osd_types.h"
 
@@ -93,3 +94,75 @@ struct BackfillInterval {
 
 std::ostream &operator<<(std::ostream &out, const BackfillInterval &bi);
 
+/**
+ * BackfillPrefetch
+ *
+ * Intervals of backfill targets scanned ahead of need: at most one per
+ * peer, either still in flight or arrived and waiting to be used.
+ */
+class BackfillPrefetch {
+  std::map<pg_shard_t, BackfillInterval> intervals;
+  std::set<pg_shard_t> pending;
+
+public:
+  /// true if a prefetch of peer was started and not yet taken
+  bool has(const pg_shard_t &peer) const {
+    return intervals.count(peer);
+  }
+
+  /// true if the scan reply for the prefetch of peer is outstanding
+  bool is_pending(const pg_shard_t &peer) const {
+    return pending.count(peer);
+  }
+
+  /// where the prefetched interval of peer begins
+  const hobject_t &get_begin(const pg_shard_t &peer) const {
+    return intervals.at(peer).begin;
+  }
+
+  /// note that a scan of peer starting at begin was sent
+  void start(const pg_shard_t &peer, const hobject_t &begin) {
+    ceph_assert(!has(peer));
+    intervals[peer].reset(begin);
+    pending.insert(peer);
+  }
+
+  /**
+   * find the interval a scan reply should fill
+   *
+   * @return the prefetched interval of peer if it is in flight and
+   * starts at begin, nullptr if the reply is not for a prefetch
+   */
+  BackfillInterval *on_reply(const pg_shard_t &peer, const hobject_t &begin) {
+    auto p = intervals.find(peer);
+    if (p == intervals.end() || !pending.count(peer) ||
+	p->second.begin != begin) {
+      return nullptr;
+    }
+    pending.erase(peer);
+    return &p->second;
+  }
+
+  /// hand over the prefetched interval of peer, which must have arrived
+  BackfillInterval take(const pg_shard_t &peer) {
+    auto p = intervals.find(peer);
+    ceph_assert(p != intervals.end());
+    ceph_assert(!pending.count(peer));
+    BackfillInterval bi = std::move(p->second);
+    intervals.erase(p);
+    return bi;
+  }
+
+  /// forget the prefetch of peer; a reply still in flight won't match
+  void discard(const pg_shard_t &peer) {
+    intervals.erase(peer);
+    pending.erase(peer);
+  }
+
+  /// forget all prefetches, on an interval change or backfill restart
+  void clear() {
+    intervals.clear();
+    pending.clear();
+  }
+};
+
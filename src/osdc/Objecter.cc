@@ -519,7 +519,7 @@ void Objecter::shutdown()
 }
 
 void Objecter::_send_linger(LingerOp *info,
-			    ceph::shunique_lock<ceph::shared_mutex>& sul)
+			    ceph::shunique_lock<rwlock_t>& sul)
 {
   ceph_assert(sul.owns_lock() && sul.mutex() == &rwlock);
 
@@ -853,7 +853,7 @@ ceph_tid_t Objecter::linger_notify(LingerOp *info,
 }
 
 void Objecter::_linger_submit(LingerOp *info,
-			      ceph::shunique_lock<ceph::shared_mutex>& sul)
+			      ceph::shunique_lock<rwlock_t>& sul)
 {
   ceph_assert(sul.owns_lock() && sul.mutex() == &rwlock);
   ceph_assert(info->linger_id);
@@ -1016,7 +1016,7 @@ void Objecter::_scan_requests(
   map<ceph_tid_t, Op*>& need_resend,
   list<LingerOp*>& need_resend_linger,
   map<ceph_tid_t, CommandOp*>& need_resend_command,
-  ceph::shunique_lock<ceph::shared_mutex>& sul)
+  ceph::shunique_lock<rwlock_t>& sul)
 {
   ceph_assert(sul.owns_lock() && sul.mutex() == &rwlock);
 
@@ -1754,7 +1754,7 @@ void Objecter::_command_cancel_map_check(CommandOp *c)
  * promotion to write.
  */
 int Objecter::_get_session(int osd, OSDSession **session,
-			   shunique_lock<ceph::shared_mutex>& sul)
+			   shunique_lock<rwlock_t>& sul)
 {
   ceph_assert(sul && sul.mutex() == &rwlock);
 
@@ -1909,7 +1909,7 @@ void Objecter::wait_for_osd_map(epoch_t e)
 
 void Objecter::_get_latest_version(epoch_t oldest, epoch_t newest,
 				   std::unique_ptr<OpCompletion> fin,
-				   std::unique_lock<ceph::shared_mutex>&& l)
+				   std::unique_lock<rwlock_t>&& l)
 {
   ceph_assert(fin);
   if (osdmap->get_epoch() >= newest) {
@@ -2031,7 +2031,7 @@ void Objecter::_kick_requests(OSDSession *session,
 }
 
 void Objecter::_linger_ops_resend(map<uint64_t, LingerOp *>& lresend,
-				  unique_lock<ceph::shared_mutex>& ul)
+				  unique_lock<rwlock_t>& ul)
 {
   ceph_assert(ul.owns_lock());
   shunique_lock sul(std::move(ul));
@@ -2192,7 +2192,7 @@ void Objecter::op_submit(Op *op, ceph_tid_t *ptid, int *ctx_budget)
 }
 
 void Objecter::_op_submit_with_budget(Op *op,
-				      shunique_lock<ceph::shared_mutex>& sul,
+				      shunique_lock<rwlock_t>& sul,
 				      ceph_tid_t *ptid,
 				      int *ctx_budget)
 {
@@ -2296,7 +2296,7 @@ void Objecter::_send_op_account(Op *op)
   }
 }
 
-void Objecter::_op_submit(Op *op, shunique_lock<ceph::shared_mutex>& sul, ceph_tid_t *ptid)
+void Objecter::_op_submit(Op *op, shunique_lock<rwlock_t>& sul, ceph_tid_t *ptid)
 {
   // rwlock is locked
 
@@ -2907,7 +2907,7 @@ int Objecter::_calc_target(op_target_t *t, Connection *con, bool any_change)
 }
 
 int Objecter::_map_session(op_target_t *target, OSDSession **s,
-			   shunique_lock<ceph::shared_mutex>& sul)
+			   shunique_lock<rwlock_t>& sul)
 {
   _calc_target(target, nullptr);
   return _get_session(target->osd, s, sul);
@@ -3014,7 +3014,7 @@ void Objecter::_session_command_op_assign(OSDSession *to, CommandOp *op)
 }
 
 int Objecter::_recalc_linger_op_target(LingerOp *linger_op,
-				       shunique_lock<ceph::shared_mutex>& sul)
+				       shunique_lock<rwlock_t>& sul)
 {
   // rwlock is locked unique
 
@@ -3231,7 +3231,7 @@ int Objecter::calc_op_budget(const bc::small_vector_base<OSDOp>& ops)
 }
 
 void Objecter::_throttle_op(Op *op,
-			    shunique_lock<ceph::shared_mutex>& sul,
+			    shunique_lock<rwlock_t>& sul,
 			    int op_budget)
 {
   ceph_assert(sul && sul.mutex() == &rwlock);
@@ -4744,7 +4744,7 @@ void Objecter::submit_command(CommandOp *c, ceph_tid_t *ptid)
 }
 
 int Objecter::_calc_command_target(CommandOp *c,
-				   shunique_lock<ceph::shared_mutex>& sul)
+				   shunique_lock<rwlock_t>& sul)
 {
   ceph_assert(sul.owns_lock() && sul.mutex() == &rwlock);
 
@@ -4800,7 +4800,7 @@ int Objecter::_calc_command_target(CommandOp *c,
 }
 
 void Objecter::_assign_command_session(CommandOp *c,
-				       shunique_lock<ceph::shared_mutex>& sul)
+				       shunique_lock<rwlock_t>& sul)
 {
   ceph_assert(sul.owns_lock() && sul.mutex() == &rwlock);
 
@@ -47,6 +47,7 @@
 #include "common/ceph_mutex.h"
 #include "common/ceph_timer.h"
 #include "common/config_obs.h"
+#include "common/sharded_shared_mutex.h"
 #include "common/shunique_lock.h"
 #include "common/zipkin_trace.h"
 #include "common/Throttle.h"
@@ -1618,6 +1619,12 @@ class Objecter : public md_config_obs_t, public Dispatcher {
 public:
   using OpSignature = void(boost::system::error_code);
   using OpCompletion = ceph::async::Completion<OpSignature>;
+#ifdef CEPH_DEBUG_MUTEX
+  // lockdep only tracks ceph::shared_mutex, keep it for debug builds
+  using rwlock_t = ceph::shared_mutex;
+#else
+  using rwlock_t = ceph::sharded_shared_mutex;
+#endif
 
   // config observer bits
   const char** get_tracked_conf_keys() const override;
@@ -1724,8 +1731,14 @@ private:
   version_t last_seen_osdmap_version = 0;
   version_t last_seen_pgmap_version = 0;
 
-  mutable ceph::shared_mutex rwlock =
-	   ceph::make_shared_mutex("Objecter::rwlock");
+  // taken shared by every op submit and reply, so spread its readers
+  // over objecter_rwlock_shards cache lines
+#ifdef CEPH_DEBUG_MUTEX
+  mutable rwlock_t rwlock = ceph::make_shared_mutex("Objecter::rwlock");
+#else
+  mutable rwlock_t rwlock{
+    cct->_conf.get_val<uint64_t>("objecter_rwlock_shards")};
+#endif
   ceph::timer<ceph::coarse_mono_clock> timer;
 
   PerfCounters* logger = nullptr;
@@ -2233,9 +2246,9 @@ public:
 
   void submit_command(CommandOp *c, ceph_tid_t *ptid);
   int _calc_command_target(CommandOp *c,
-			   ceph::shunique_lock<ceph::shared_mutex> &sul);
+			   ceph::shunique_lock<rwlock_t> &sul);
   void _assign_command_session(CommandOp *c,
-			       ceph::shunique_lock<ceph::shared_mutex> &sul);
+			       ceph::shunique_lock<rwlock_t> &sul);
   void _send_command(CommandOp *c);
   int command_op_cancel(OSDSession *s, ceph_tid_t tid,
 			boost::system::error_code ec);
@@ -2468,7 +2481,7 @@ public:
   int _calc_target(op_target_t *t, Connection *con,
 		   bool any_change = false);
   int _map_session(op_target_t *op, OSDSession **s,
-		   ceph::shunique_lock<ceph::shared_mutex>& lc);
+		   ceph::shunique_lock<rwlock_t>& lc);
 
   void _session_op_assign(OSDSession *s, Op *op);
   void _session_op_remove(OSDSession *s, Op *op);
@@ -2477,16 +2490,16 @@ public:
   void _session_command_op_assign(OSDSession *to, CommandOp *op);
   void _session_command_op_remove(OSDSession *from, CommandOp *op);
 
-  int _assign_op_target_session(Op *op, ceph::shunique_lock<ceph::shared_mutex>& lc,
+  int _assign_op_target_session(Op *op, ceph::shunique_lock<rwlock_t>& lc,
 				bool src_session_locked,
 				bool dst_session_locked);
   int _recalc_linger_op_target(LingerOp *op,
-			       ceph::shunique_lock<ceph::shared_mutex>& lc);
+			       ceph::shunique_lock<rwlock_t>& lc);
 
   void _linger_submit(LingerOp *info,
-		      ceph::shunique_lock<ceph::shared_mutex>& sul);
+		      ceph::shunique_lock<rwlock_t>& sul);
   void _send_linger(LingerOp *info,
-		    ceph::shunique_lock<ceph::shared_mutex>& sul);
+		    ceph::shunique_lock<rwlock_t>& sul);
   void _linger_commit(LingerOp *info, boost::system::error_code ec,
 		      ceph::buffer::list& outbl);
   void _linger_reconnect(LingerOp *info, boost::system::error_code ec);
@@ -2517,10 +2530,10 @@ private:
 
   void _kick_requests(OSDSession *session, std::map<uint64_t, LingerOp *>& lresend);
   void _linger_ops_resend(std::map<uint64_t, LingerOp *>& lresend,
-			  std::unique_lock<ceph::shared_mutex>& ul);
+			  std::unique_lock<rwlock_t>& ul);
 
   int _get_session(int osd, OSDSession **session,
-		   ceph::shunique_lock<ceph::shared_mutex>& sul);
+		   ceph::shunique_lock<rwlock_t>& sul);
   void put_session(OSDSession *s);
   void get_session(OSDSession *s);
   void _reopen_session(OSDSession *session);
@@ -2538,9 +2551,9 @@ private:
    * If throttle_op needs to throttle it will unlock client_lock.
    */
   int calc_op_budget(const boost::container::small_vector_base<OSDOp>& ops);
-  void _throttle_op(Op *op, ceph::shunique_lock<ceph::shared_mutex>& sul,
+  void _throttle_op(Op *op, ceph::shunique_lock<rwlock_t>& sul,
 		    int op_size = 0);
-  int _take_op_budget(Op *op, ceph::shunique_lock<ceph::shared_mutex>& sul) {
+  int _take_op_budget(Op *op, ceph::shunique_lock<rwlock_t>& sul) {
     ceph_assert(sul && sul.mutex() == &rwlock);
     int op_budget = calc_op_budget(op->ops);
     if (keep_balanced_budget) {
@@ -2619,7 +2632,7 @@ private:
     std::map<ceph_tid_t, Op*>& need_resend,
     std::list<LingerOp*>& need_resend_linger,
     std::map<ceph_tid_t, CommandOp*>& need_resend_command,
-    ceph::shunique_lock<ceph::shared_mutex>& sul);
+    ceph::shunique_lock<rwlock_t>& sul);
 
   int64_t get_object_hash_position(int64_t pool, const std::string& key,
 				   const std::string& ns);
@@ -2698,10 +2711,10 @@ private:
                              const OSDMap &new_osd_map);
 
   // low-level
-  void _op_submit(Op *op, ceph::shunique_lock<ceph::shared_mutex>& lc,
+  void _op_submit(Op *op, ceph::shunique_lock<rwlock_t>& lc,
 		  ceph_tid_t *ptid);
   void _op_submit_with_budget(Op *op,
-			      ceph::shunique_lock<ceph::shared_mutex>& lc,
+			      ceph::shunique_lock<rwlock_t>& lc,
 			      ceph_tid_t *ptid,
 			      int *ctx_budget = NULL);
   // public interface
@@ -2814,7 +2827,7 @@ public:
 
   void _get_latest_version(epoch_t oldest, epoch_t neweset,
 			   std::unique_ptr<OpCompletion> fin,
-			   std::unique_lock<ceph::shared_mutex>&& ul);
+			   std::unique_lock<rwlock_t>&& ul);
 
   /** Get the current set of global op flags */
   int get_global_op_flags() const { return global_op_flags; }
@@ -0,0 +1,184 @@
+// -*- mode:C++; tab-width:8; c-basic-offset:2; indent-tabs-mode:t -*-
+// vim: ts=8 sw=2 smarttab
+
+/*
+ * Measures how long encoding and decoding typical messages and
+ * structures takes, and how many heap allocations it costs.  Runs with
+ * CEPH_BUFFER_NO_THREAD_CACHE=1 set in the environment show what the
+ * per-thread ptr_node cache saves.
+ */
+
+#include <dlfcn.h>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <new>
+
+#include "include/buffer.h"
+#include "include/encoding.h"
+#include "common/ceph_argparse.h"
+#include "common/common_init.h"
+#include "global/global_init.h"
+#include "messages/MOSDOp.h"
+#include "msg/Message.h"
+#include "osd/osd_types.h"
+
+// count the allocations of this process: operator new, and
+// posix_memalign which the buffer code allocates its buffers with
+static std::atomic<uint64_t> num_allocs{0};
+
+void* operator new(size_t size)
+{
+  ++num_allocs;
+  if (void* p = malloc(size ? size : 1); p) {
+    return p;
+  }
+  throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept
+{
+  free(p);
+}
+
+void operator delete(void* p, size_t) noexcept
+{
+  free(p);
+}
+
+extern "C" int posix_memalign(void **memptr, size_t alignment, size_t size)
+{
+  using posix_memalign_t = int (*)(void**, size_t, size_t);
+  static posix_memalign_t real_posix_memalign =
+    reinterpret_cast<posix_memalign_t>(dlsym(RTLD_NEXT, "posix_memalign"));
+  ++num_allocs;
+  return real_posix_memalign(memptr, alignment, size);
+}
+
+static void run(const char* name, unsigned iterations,
+		const std::function<void()>& fn)
+{
+  // warm up, and let the cache fill
+  for (unsigned i = 0; i < iterations / 10 + 1; i++) {
+    fn();
+  }
+  uint64_t allocs = num_allocs;
+  auto start = std::chrono::steady_clock::now();
+  for (unsigned i = 0; i < iterations; i++) {
+    fn();
+  }
+  std::chrono::duration<double, std::nano> elapsed =
+    std::chrono::steady_clock::now() - start;
+  std::cout << std::left << std::setw(28) << name << std::right
+	    << std::setw(10) << std::fixed << std::setprecision(1)
+	    << elapsed.count() / iterations << " ns"
+	    << std::setw(10) << std::setprecision(2)
+	    << double(num_allocs - allocs) / iterations << " allocs"
+	    << std::endl;
+}
+
+static MOSDOp* make_osd_op(unsigned data_len)
+{
+  hobject_t hobj(object_t("rbd_data.1234567890.0000000000000042"), "",
+		 CEPH_NOSNAP, 0x1234, 1, "");
+  spg_t spgid(pg_t(0x34, 1));
+  auto m = new MOSDOp(0, 1, hobj, spgid, 100, CEPH_OSD_FLAG_WRITE, 0);
+  if (data_len) {
+    bufferlist data;
+    data.append_zero(data_len);
+    m->write(0, data_len, data);
+  } else {
+    m->stat();
+  }
+  return m;
+}
+
+void usage(const char *name)
+{
+  std::cout << name << " [iterations]\n"
+	    << "\t iterations: the number of rounds of each test, "
+	    << "100000 by default\n";
+}
+
+int main(int argc, const char **argv)
+{
+  vector<const char*> args;
+  argv_to_vec(argc, argv, args);
+
+  auto cct = global_init(NULL, args, CEPH_ENTITY_TYPE_CLIENT,
+			 CODE_ENVIRONMENT_UTILITY,
+			 CINIT_FLAG_NO_DEFAULT_CONFIG_FILE);
+  common_init_finish(g_ceph_context);
+
+  unsigned iterations = 100000;
+  if (args.size() > 1) {
+    usage(argv[0]);
+    return EXIT_FAILURE;
+  } else if (args.size() == 1) {
+    iterations = atoi(args[0]);
+  }
+  std::cout << iterations << " iterations" << std::endl;
+
+  run("encode 64 x u32", iterations, [] {
+    bufferlist bl;
+    for (uint32_t i = 0; i < 64; i++) {
+      encode(i, bl);
+    }
+  });
+
+  run("append + claim small", iterations, [] {
+    bufferlist bl, other;
+    for (unsigned i = 0; i < 8; i++) {
+      other.append(buffer::copy("0123456789", 10));
+    }
+    bl.claim_append(other);
+  });
+
+  std::list<pg_log_entry_t*> entries;
+  pg_log_entry_t::generate_test_instances(entries);
+  const pg_log_entry_t& entry = *entries.back();
+  bufferlist entry_bl;
+  encode(entry, entry_bl);
+
+  run("encode pg_log_entry_t", iterations, [&entry] {
+    bufferlist bl;
+    encode(entry, bl);
+  });
+
+  run("decode pg_log_entry_t", iterations, [&entry_bl] {
+    pg_log_entry_t e;
+    auto p = entry_bl.cbegin();
+    decode(e, p);
+  });
+
+  for (unsigned data_len : {0u, 4096u}) {
+    std::string name = "MOSDOp (data " + std::to_string(data_len) + ")";
+    bufferlist msg_bl;
+    {
+      auto m = make_osd_op(data_len);
+      encode_message(m, CEPH_FEATURES_ALL, msg_bl);
+      m->put();
+    }
+
+    run(("encode " + name).c_str(), iterations, [data_len] {
+      auto m = make_osd_op(data_len);
+      bufferlist bl;
+      encode_message(m, CEPH_FEATURES_ALL, bl);
+      m->put();
+    });
+
+    run(("decode " + name).c_str(), iterations, [&msg_bl, &cct] {
+      auto p = msg_bl.cbegin();
+      auto m = decode_message(cct.get(), 0, p);
+      static_cast<MOSDOp*>(m)->finish_decode();
+      m->put();
+    });
+  }
+
+  for (auto e : entries) {
+    delete e;
+  }
+  return 0;
+}
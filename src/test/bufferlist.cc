@@ -22,6 +22,7 @@
 #include <limits.h>
 #include <errno.h>
 #include <sys/uio.h>
+#include <thread>
 
 #include "include/buffer.h"
 #include "include/buffer_raw.h"
@@ -2835,6 +2836,53 @@ TEST(BufferList, TestIsProvidedBuffer) {
   ASSERT_FALSE(bl.is_provided_buffer(buff));
 }
 
+TEST(BufferList, FreeOnOtherThread) {
+  if (get_env_bool("CEPH_BUFFER_NO_THREAD_CACHE")) {
+    GTEST_SKIP() << "CEPH_BUFFER_NO_THREAD_CACHE is set";
+  }
+  // the nodes freed by one thread are cached for reuse by that thread,
+  // and freed when it exits
+  std::vector<bufferlist> bls(100);
+  for (int round = 0; round < 3; round++) {
+    std::thread producer([&bls, round] {
+      for (auto& bl : bls) {
+        for (uint32_t i = 0; i < 2000; i++) {
+          encode(i + round, bl);
+        }
+      }
+    });
+    producer.join();
+    int reclaimed = buffer::get_reclaimed_nodes();
+    int cached = 0;
+    std::thread consumer([&bls, round, &cached] {
+      ASSERT_EQ(0, buffer::get_thread_cached_nodes());
+      for (auto& bl : bls) {
+        ASSERT_EQ(2000u * sizeof(uint32_t), bl.length());
+        auto p = bl.cbegin();
+        for (uint32_t i = 0; i < 2000; i++) {
+          uint32_t v;
+          decode(v, p);
+          ASSERT_EQ(i + round, v);
+        }
+        bl.clear();
+      }
+      cached = buffer::get_thread_cached_nodes();
+      ASSERT_LT(0, cached);
+      ASSERT_GE(256, cached);
+      {
+        // a new node comes from the cache, and goes back to it
+        bufferlist bl;
+        bl.push_back(buffer::create(16));
+        ASSERT_EQ(cached - 1, buffer::get_thread_cached_nodes());
+      }
+      ASSERT_EQ(cached, buffer::get_thread_cached_nodes());
+    });
+    consumer.join();
+    ASSERT_LT(0, cached);
+    ASSERT_EQ(reclaimed + cached, buffer::get_reclaimed_nodes());
+  }
+}
+
 TEST(BufferList, DISABLED_DanglingLastP) {
   bufferlist bl;
   {
@@ -32,4 +32,15 @@
      --dump <format>         displays the map in plain text when <format> is 'plain', 'json' if specified format is not supported
      --tree                  displays a tree of the map
      --test-crush [--range-first <first> --range-last <last>] map pgs to acting osds
+     --adjust-crush-weight <osdid:weight>[,<osdid:weight>,<...>] change <osdid> CRUSH <weight> (but do not persist)
+     --preview-pg-movement   show which pgs the other changes requested
+                             (--import-crush, --adjust-crush-weight, --mark-out,
+                             --upmap, ...) would move; the map is never written,
+                             so --upmap-save cannot be combined with it
+     --pg-stats <file>       'ceph pg dump --format json' output used by
+                             --preview-pg-movement to estimate bytes moved
+     --preview-threads <n>   threads used to map pgs [default: number of cpus]
+     --preview-json          dump the --preview-pg-movement result as json
+     --test-incremental-mapping  time the full and the incremental pg
+                             mapping update for marking one osd down
   [1]
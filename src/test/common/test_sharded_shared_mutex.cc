@@ -0,0 +1,165 @@
+// -*- mode:C++; tab-width:8; c-basic-offset:2; indent-tabs-mode:t -*-
+// vim: ts=8 sw=2 smarttab
+
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <iostream>
+#include <mutex>
+#include <shared_mutex>
+#include <thread>
+#include <vector>
+
+#include "common/sharded_shared_mutex.h"
+#include "common/shunique_lock.h"
+
+#include "gtest/gtest.h"
+
+static bool test_try_lock(ceph::sharded_shared_mutex* sm) {
+  if (!sm->try_lock())
+    return false;
+  sm->unlock();
+  return true;
+}
+
+static bool test_try_lock_shared(ceph::sharded_shared_mutex* sm) {
+  if (!sm->try_lock_shared())
+    return false;
+  sm->unlock_shared();
+  return true;
+}
+
+static bool async_try_lock(ceph::sharded_shared_mutex& sm) {
+  return std::async(std::launch::async, &test_try_lock, &sm).get();
+}
+
+static bool async_try_lock_shared(ceph::sharded_shared_mutex& sm) {
+  return std::async(std::launch::async, &test_try_lock_shared, &sm).get();
+}
+
+TEST(ShardedSharedMutex, Exclusive) {
+  ceph::sharded_shared_mutex sm(8);
+  ASSERT_EQ(8u, sm.get_num_shards());
+  {
+    std::unique_lock l(sm);
+    // every shard is held, whichever one the other thread maps to
+    for (int i = 0; i < 16; ++i) {
+      ASSERT_FALSE(async_try_lock(sm));
+      ASSERT_FALSE(async_try_lock_shared(sm));
+    }
+  }
+  ASSERT_TRUE(async_try_lock(sm));
+  ASSERT_TRUE(async_try_lock_shared(sm));
+}
+
+TEST(ShardedSharedMutex, Shared) {
+  ceph::sharded_shared_mutex sm(8);
+  {
+    std::shared_lock l(sm);
+    for (int i = 0; i < 16; ++i) {
+      ASSERT_FALSE(async_try_lock(sm));
+      ASSERT_TRUE(async_try_lock_shared(sm));
+    }
+  }
+  ASSERT_TRUE(async_try_lock(sm));
+}
+
+TEST(ShardedSharedMutex, TryLockBacksOut) {
+  ceph::sharded_shared_mutex sm(8);
+  std::promise<void> locked, release;
+  auto reader = std::async(std::launch::async, [&] {
+    std::shared_lock l(sm);
+    locked.set_value();
+    release.get_future().wait();
+  });
+  locked.get_future().wait();
+  ASSERT_FALSE(sm.try_lock());
+  // a failed try_lock must not leave any shard held
+  release.set_value();
+  reader.get();
+  ASSERT_TRUE(async_try_lock_shared(sm));
+  ASSERT_TRUE(sm.try_lock());
+  sm.unlock();
+}
+
+TEST(ShardedSharedMutex, Shunique) {
+  ceph::sharded_shared_mutex sm(4);
+  ceph::shunique_lock sul(sm, ceph::acquire_shared);
+  ASSERT_TRUE(sul.owns_lock_shared());
+  ASSERT_FALSE(async_try_lock(sm));
+  sul.unlock();
+  sul.lock();
+  ASSERT_TRUE(sul.owns_lock());
+  ASSERT_FALSE(async_try_lock_shared(sm));
+  sul.unlock();
+  ASSERT_TRUE(async_try_lock(sm));
+}
+
+TEST(ShardedSharedMutex, WritersSeeConsistentState) {
+  ceph::sharded_shared_mutex sm(4);
+  int a = 0, b = 0;
+  std::atomic<bool> stop = false;
+  std::atomic<int> torn = 0;
+  std::vector<std::thread> readers;
+  for (int i = 0; i < 4; ++i) {
+    readers.emplace_back([&] {
+      while (!stop) {
+	std::shared_lock l(sm);
+	if (a != b)
+	  ++torn;
+      }
+    });
+  }
+  for (int i = 0; i < 10000; ++i) {
+    std::unique_lock l(sm);
+    ++a;
+    ++b;
+  }
+  stop = true;
+  for (auto& t : readers)
+    t.join();
+  ASSERT_EQ(0, torn);
+  ASSERT_EQ(10000, a);
+}
+
+// not a pass/fail test: report shared lock/unlock throughput as the number
+// of threads grows, for a plain shared_mutex and for the sharded one.
+// run it with --gtest_also_run_disabled_tests
+template<typename Mutex>
+static double shared_locks_per_sec(Mutex& m, int threads)
+{
+  std::atomic<bool> stop = false;
+  std::atomic<uint64_t> total = 0;
+  std::vector<std::thread> workers;
+  for (int i = 0; i < threads; ++i) {
+    workers.emplace_back([&] {
+      uint64_t n = 0;
+      while (!stop) {
+	for (int j = 0; j < 1000; ++j) {
+	  std::shared_lock l(m);
+	}
+	n += 1000;
+      }
+      total += n;
+    });
+  }
+  auto duration = std::chrono::milliseconds(200);
+  std::this_thread::sleep_for(duration);
+  stop = true;
+  for (auto& t : workers)
+    t.join();
+  return total / std::chrono::duration<double>(duration).count();
+}
+
+TEST(ShardedSharedMutex, DISABLED_SharedScaling) {
+  unsigned max_threads = std::max(2u, std::thread::hardware_concurrency());
+  std::cout << "threads\tshared_mutex/s\tsharded/s" << std::endl;
+  for (unsigned threads = 1; threads <= max_threads; threads *= 2) {
+    std::shared_mutex plain;
+    ceph::sharded_shared_mutex sharded(16);
+    std::cout << threads
+	      << "\t" << shared_locks_per_sec(plain, threads)
+	      << "\t" << shared_locks_per_sec(sharded, threads)
+	      << std::endl;
+  }
+}
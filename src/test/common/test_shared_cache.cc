@@ -393,6 +393,60 @@ TEST(SharedCache_all, lru) {
   ASSERT_TRUE(cache.lookup(0).get());
 }
 
+namespace {
+// an ordered key that counts how often it is compared
+struct CountedKey {
+  static inline unsigned compares = 0;
+  int k;
+  bool operator<(const CountedKey& rhs) const {
+    ++compares;
+    return k < rhs.k;
+  }
+  bool operator==(const CountedKey& rhs) const {
+    return k == rhs.k;
+  }
+};
+std::ostream& operator<<(std::ostream& out, const CountedKey& key) {
+  return out << key.k;
+}
+}
+
+namespace std {
+template<> struct hash<CountedKey> {
+  size_t operator()(const CountedKey& key) const {
+    return hash<int>{}(key.k);
+  }
+};
+}
+
+TEST(SharedCache_all, lru_lookup_skips_weak_refs) {
+  const int SIZE = 5;
+  SharedLRU<CountedKey, int> cache(NULL, SIZE);
+
+  for (int i = 0; i < SIZE; ++i) {
+    cache.add(CountedKey{i}, new int(i));
+  }
+  std::shared_ptr<int> held = cache.lookup(CountedKey{0});
+  ASSERT_EQ(0, *held);
+
+  // hits on the lru, whether or not someone else holds a ref, are served
+  // from the hash index without touching the ordered weak_refs map
+  CountedKey::compares = 0;
+  for (int i = SIZE - 1; i >= 0; --i) {
+    ASSERT_EQ(i, *cache.lookup(CountedKey{i}));
+  }
+  ASSERT_EQ(0u, CountedKey::compares);
+
+  // ... and still promote: 0 is now the most recently used, 4 the least
+  cache.add(CountedKey{SIZE}, new int(SIZE));
+  ASSERT_FALSE(cache.lookup(CountedKey{SIZE - 1}));
+  ASSERT_LT(0u, CountedKey::compares);
+  CountedKey::compares = 0;
+  ASSERT_EQ(held, cache.lookup(CountedKey{0}));
+  ASSERT_EQ(0u, CountedKey::compares);
+  ASSERT_EQ(SIZE, cache.get_count());
+}
+
 // Local Variables:
 // compile-command: "cd ../.. ; make unittest_shared_cache && ./unittest_shared_cache # --gtest_filter=*.* --log-to-stderr=true"
 // End:
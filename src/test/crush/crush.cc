@@ -656,3 +656,61 @@ TEST_F(CRUSHTest, straw2_reweight) {
     cout << "     vs " << estddev << std::endl;
   }
 }
+
+TEST_F(CRUSHTest, straw2_batch_hash) {
+  // more items than one straw2 hash batch, with some zero weights
+  const int n = 70;
+  int items[n];
+  int weights[n];
+  for (int i = 0; i < n; ++i) {
+    items[i] = i;
+    weights[i] = (i % 7 == 3) ? 0 : 0x10000 * (1 + i % 5);
+  }
+
+  unsigned hashes[n];
+  crush_hash32_3_multi(CRUSH_HASH_RJENKINS1, 1234, items, 5, hashes, n);
+  for (int i = 0; i < n; ++i) {
+    ASSERT_EQ(crush_hash32_3(CRUSH_HASH_RJENKINS1, 1234, items[i], 5),
+	      hashes[i]);
+  }
+
+  std::unique_ptr<CrushWrapper> c(new CrushWrapper);
+  c->set_type_name(1, "root");
+  c->set_type_name(0, "osd");
+  c->set_max_devices(n);
+  int root;
+  crush_bucket *b = crush_make_bucket(c->get_crush_map(),
+				      CRUSH_BUCKET_STRAW2, CRUSH_HASH_RJENKINS1,
+				      1, n, items, weights);
+  EXPECT_EQ(0, crush_add_bucket(c->get_crush_map(), 0, b, &root));
+  EXPECT_EQ(0, c->set_item_name(root, "root"));
+  int rule = c->add_simple_rule("rule", "root", "osd", "",
+				"firstn", pg_pool_t::TYPE_REPLICATED);
+  EXPECT_EQ(0, rule);
+  c->finalize();
+
+  // placements computed by the item-at-a-time straw2 code this replaced
+  vector<__u32> reweight(n, 0x10000);
+  reweight[10] = 0x8000;
+  const vector<vector<int>> expected = {
+    {13, 12, 43}, {69, 13, 34}, {13, 69, 43}, {44, 49, 48},
+    {37, 28, 69}, {36, 43, 64}, {58, 41, 14}, {43, 4, 33},
+  };
+  for (unsigned x = 0; x < expected.size(); ++x) {
+    vector<int> out;
+    c->do_rule(rule, x, out, 3, reweight, 0);
+    ASSERT_EQ(expected[x], out) << "x " << x;
+  }
+  // and a fingerprint of the first 10000 placements, from the same code
+  uint32_t fp = 0;
+  for (int x = 0; x < 10000; ++x) {
+    vector<int> out;
+    c->do_rule(rule, x, out, 3, reweight, 0);
+    fp = fp * 31 + out.size();
+    for (auto o : out) {
+      ASSERT_NE(0, weights[o]);
+      fp = fp * 31 + o;
+    }
+  }
+  ASSERT_EQ(0xfbc3f01bu, fp);
+}
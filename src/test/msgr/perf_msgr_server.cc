@@ -113,9 +113,11 @@ class MessengerServer {
   DummyAuthClientServer dummy_auth;
 
  public:
-  MessengerServer(const string &t, const string &addr, int threads, int delay):
+  MessengerServer(const string &t, const string &addr, int threads, int delay,
+                  uint32_t con_mode):
       msgr(NULL), type(t), bindaddr(addr), dispatcher(threads, delay),
       dummy_auth(g_ceph_context) {
+    dummy_auth.set_con_mode(con_mode);
     msgr = Messenger::create(g_ceph_context, type, entity_name_t::OSD(0), "server", 0, 0);
     msgr->set_default_policy(Messenger::Policy::stateless_server(0));
     dummy_auth.auth_registry.refresh_config();
@@ -136,10 +138,11 @@ class MessengerServer {
 };
 
 void usage(const string &name) {
-  cerr << "Usage: " << name << " [bind ip:port] [server worker threads] [thinktime us]" << std::endl;
+  cerr << "Usage: " << name << " [bind ip:port] [server worker threads] [thinktime us] [mode]" << std::endl;
   cerr << "       [bind ip:port]: The ip:port pair to bind, client need to specify this pair to connect" << std::endl;
   cerr << "       [server worker threads]: threads will process incoming messages and reply(matching pg threads)" << std::endl;
   cerr << "       [thinktime]: sleep time when do dispatching(match fast dispatch logic in OSD.cc)" << std::endl;
+  cerr << "       [mode]: connection mode, crc (default) or secure; must match the client's" << std::endl;
 }
 
 int main(int argc, char **argv)
@@ -160,6 +163,11 @@ int main(int argc, char **argv)
 
   int worker_threads = atoi(args[1]);
   int think_time = atoi(args[2]);
+  std::string mode = args.size() > 3 ? args[3] : "crc";
+  if (mode != "crc" && mode != "secure") {
+    usage(argv[0]);
+    return 1;
+  }
   std::string public_msgr_type = g_ceph_context->_conf->ms_public_type.empty() ? g_ceph_context->_conf.get_val<std::string>("ms_type") : g_ceph_context->_conf->ms_public_type;
 
   cerr << " This tool won't handle connection error alike things, " << std::endl;
@@ -169,8 +177,10 @@ int main(int argc, char **argv)
   cerr << "       bind ip:port " << args[0] << std::endl;
   cerr << "       worker threads " << worker_threads << std::endl;
   cerr << "       thinktime(us) " << think_time << std::endl;
+  cerr << "       mode " << mode << std::endl;
 
-  MessengerServer server(public_msgr_type, args[0], worker_threads, think_time);
+  MessengerServer server(public_msgr_type, args[0], worker_threads, think_time,
+                         mode == "secure" ? CEPH_CON_MODE_SECURE : CEPH_CON_MODE_CRC);
   server.start();
 
   return 0;
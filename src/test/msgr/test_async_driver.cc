@@ -55,6 +55,9 @@
 #include "msg/async/EventKqueue.h"
 #endif
 #include "msg/async/EventSelect.h"
+#ifdef HAVE_ASYNC_URING
+#include "msg/async/uring/EventUring.h"
+#endif
 
 #include <gtest/gtest.h>
 
@@ -76,6 +79,12 @@ class EventDriverTest : public ::testing::TestWithParam<const char*> {
 #endif
     if (strcmp(GetParam(), "select"))
       driver = new SelectDriver(g_ceph_context);
+#ifdef HAVE_ASYNC_URING
+    if (!strcmp(GetParam(), "uring")) {
+      delete driver;
+      driver = new UringDriver(g_ceph_context);
+    }
+#endif
     driver->init(NULL, 100);
   }
   void TearDown() override {
@@ -339,6 +348,9 @@ INSTANTIATE_TEST_SUITE_P(
 #endif
 #ifdef HAVE_KQUEUE
     "kqueue",
+#endif
+#ifdef HAVE_ASYNC_URING
+    "uring",
 #endif
     "select"
   )
@@ -274,6 +274,214 @@ TEST_P(NetworkWorkerTest, SimpleTest) {
   });
 }
 
+TEST_P(NetworkWorkerTest, ZeroCopyTest) {
+  if (strcmp(GetParam(), "posix")) {
+    GTEST_SKIP() << "only the posix stack sends with MSG_ZEROCOPY";
+  }
+  entity_addr_t bind_addr;
+  ASSERT_TRUE(bind_addr.parse(get_addr().c_str()));
+  // picked up by the sockets connected and accepted from now on
+  NoopConfigObserver obs({"ms_tcp_zerocopy_min_size"});
+  auto& conf = g_ceph_context->_conf;
+  conf.add_observer(&obs);
+  int r = conf.set_val("ms_tcp_zerocopy_min_size", "65536");
+  if (r == 0) {
+    exec_events([bind_addr](Worker *worker) mutable {
+      if (worker->id != 0)
+        return;
+      entity_addr_t cli_addr;
+      SocketOptions options;
+      ServerSocket bind_socket;
+      EventCenter *center = &worker->center;
+      ASSERT_EQ(0, worker->listen(bind_addr, 0, options, &bind_socket));
+      ConnectedSocket cli_socket, srv_socket;
+      ASSERT_EQ(0, worker->connect(bind_addr, options, &cli_socket));
+      {
+        C_poll cb(center);
+        center->create_file_event(bind_socket.fd(), EVENT_READABLE, &cb);
+        ASSERT_TRUE(cb.poll(500));
+        center->delete_file_event(bind_socket.fd(), EVENT_READABLE);
+      }
+      ASSERT_EQ(0, bind_socket.accept(&srv_socket, options, &cli_addr, worker));
+      {
+        C_poll cb(center);
+        center->create_file_event(cli_socket.fd(), EVENT_READABLE, &cb);
+        ssize_t r = cli_socket.is_connected();
+        if (r == 0) {
+          ASSERT_EQ(true, cb.poll(500));
+          r = cli_socket.is_connected();
+        }
+        ASSERT_EQ(1, r);
+        center->delete_file_event(cli_socket.fd(), EVENT_READABLE);
+      }
+
+      PerfCounters *logger = worker->perf_logger;
+      const unsigned len = 1 << 20;
+      bufferptr data(buffer::create_page_aligned(len));
+      data.zero();
+      char buf[65536];
+      C_poll cb(center);
+      center->create_file_event(srv_socket.fd(), EVENT_READABLE, &cb);
+      uint64_t zerocopy_bytes = 0;
+      for (int round = 0; round < 2; ++round) {
+        zerocopy_bytes = logger->get(l_msgr_send_zerocopy_bytes);
+        uint64_t copied = logger->get(l_msgr_send_zerocopy_copied);
+        bufferlist bl;
+        bl.append(data);
+        size_t received = 0;
+        while (received < len) {
+          if (bl.length()) {
+            ASSERT_LE(0, cli_socket.send(bl, false));
+          }
+          ssize_t r = srv_socket.read(buf, sizeof(buf));
+          if (r == -EAGAIN) {
+            cb.poll(500);
+            cb.reset();
+            continue;
+          }
+          ASSERT_LT(0, r);
+          received += r;
+        }
+        if (round > 0) {
+          break;
+        }
+        if (logger->get(l_msgr_send_zerocopy_bytes) == zerocopy_bytes) {
+          GTEST_SKIP() << "the kernel does not support SO_ZEROCOPY";
+        }
+
+        // the sender pins the data until the kernel reports it done, which
+        // it does through the error queue: that makes the socket readable
+        // with nothing to read, until the reports are consumed
+        C_poll errcb(center);
+        center->create_file_event(cli_socket.fd(), EVENT_READABLE, &errcb);
+        while (data.raw_nref() > 1) {
+          ASSERT_TRUE(errcb.poll(1000));
+          errcb.reset();
+          cli_socket.drain_error_queue();
+        }
+        errcb.reset();
+        ASSERT_FALSE(errcb.poll(100));
+        center->delete_file_event(cli_socket.fd(), EVENT_READABLE);
+        // loopback copies anyway, which turns zerocopy off for the socket
+        ASSERT_LT(copied, logger->get(l_msgr_send_zerocopy_copied));
+      }
+      // the second round went out without MSG_ZEROCOPY
+      ASSERT_EQ(zerocopy_bytes, logger->get(l_msgr_send_zerocopy_bytes));
+      center->delete_file_event(srv_socket.fd(), EVENT_READABLE);
+      bind_socket.abort_accept();
+    });
+  }
+  conf.set_val("ms_tcp_zerocopy_min_size", "0");
+  conf.remove_observer(&obs);
+  ASSERT_EQ(0, r);
+}
+
+TEST_P(NetworkWorkerTest, SendQueueTest) {
+  if (strcmp(GetParam(), "uring")) {
+    GTEST_SKIP() << "only the uring stack queues what it sends itself";
+  }
+  entity_addr_t bind_addr;
+  ASSERT_TRUE(bind_addr.parse(get_addr().c_str()));
+  // picked up by the sockets connected and accepted from now on
+  NoopConfigObserver obs({"ms_async_uring_send_queue_max"});
+  auto& conf = g_ceph_context->_conf;
+  conf.add_observer(&obs);
+  int r = conf.set_val("ms_async_uring_send_queue_max", "65536");
+  if (r == 0) {
+    exec_events([bind_addr](Worker *worker) mutable {
+      if (worker->id != 0)
+        return;
+      entity_addr_t cli_addr;
+      SocketOptions options;
+      ServerSocket bind_socket;
+      EventCenter *center = &worker->center;
+      ASSERT_EQ(0, worker->listen(bind_addr, 0, options, &bind_socket));
+      ConnectedSocket cli_socket, srv_socket;
+      ASSERT_EQ(0, worker->connect(bind_addr, options, &cli_socket));
+      {
+        C_poll cb(center);
+        center->create_file_event(bind_socket.fd(), EVENT_READABLE, &cb);
+        ASSERT_TRUE(cb.poll(500));
+        center->delete_file_event(bind_socket.fd(), EVENT_READABLE);
+      }
+      ASSERT_EQ(0, bind_socket.accept(&srv_socket, options, &cli_addr, worker));
+      {
+        C_poll cb(center);
+        center->create_file_event(cli_socket.fd(), EVENT_READABLE, &cb);
+        ssize_t r = cli_socket.is_connected();
+        if (r == 0) {
+          ASSERT_EQ(true, cb.poll(500));
+          r = cli_socket.is_connected();
+        }
+        ASSERT_EQ(1, r);
+        center->delete_file_event(cli_socket.fd(), EVENT_READABLE);
+      }
+
+      const unsigned queue_max = 65536;
+      // more than the kernel buffers on both ends take
+      const unsigned len = 64 << 20;
+      bufferptr data(buffer::create_page_aligned(len));
+      for (unsigned i = 0; i < len; ++i) {
+        data.c_str()[i] = i % 251;
+      }
+      bufferlist bl;
+      bl.append(data);
+
+      // nobody reads yet: send() takes no more than the queue has room
+      // for, until it takes nothing and the rest stays with the caller
+      bool full = false;
+      for (unsigned i = 0; i < len / queue_max * 4 && !full; ++i) {
+        ssize_t r = cli_socket.send(bl, false);
+        ASSERT_LE(0, r);
+        ASSERT_GE(queue_max, r);
+        full = r == 0;
+        center->process_events(500);
+      }
+      ASSERT_TRUE(full);
+      ASSERT_LT(0u, bl.length());
+
+      // the reader catches up; the writer sends what is left as the
+      // queue drains, and closes right after its last send
+      C_poll wcb(center), rcb(center);
+      center->create_file_event(cli_socket.fd(), EVENT_WRITABLE, &wcb);
+      center->create_file_event(srv_socket.fd(), EVENT_READABLE, &rcb);
+      char buf[65536];
+      size_t received = 0;
+      while (true) {
+        if (bl.length() && wcb.poll(0)) {
+          wcb.reset();
+          ASSERT_LE(0, cli_socket.send(bl, false));
+          if (!bl.length()) {
+            center->delete_file_event(cli_socket.fd(), EVENT_WRITABLE);
+            // whatever is still queued goes out after the close
+            cli_socket.close();
+          }
+        }
+        ssize_t r = srv_socket.read(buf, sizeof(buf));
+        if (r == -EAGAIN) {
+          rcb.poll(500);
+          rcb.reset();
+          continue;
+        }
+        ASSERT_LE(0, r);
+        if (r == 0) {
+          break;
+        }
+        ASSERT_GE(len, received + r);
+        ASSERT_EQ(0, memcmp(buf, data.c_str() + received, r));
+        received += r;
+      }
+      ASSERT_EQ(0u, bl.length());
+      ASSERT_EQ(len, received);
+      center->delete_file_event(srv_socket.fd(), EVENT_READABLE);
+      bind_socket.abort_accept();
+    });
+  }
+  conf.rm_val("ms_async_uring_send_queue_max");
+  conf.remove_observer(&obs);
+  ASSERT_EQ(0, r);
+}
+
 TEST_P(NetworkWorkerTest, ConnectFailedTest) {
   entity_addr_t bind_addr;
   ASSERT_TRUE(bind_addr.parse(get_addr().c_str()));
@@ -1061,6 +1269,9 @@ INSTANTIATE_TEST_SUITE_P(
   ::testing::Values(
 #ifdef HAVE_DPDK
     "dpdk",
+#endif
+#ifdef HAVE_ASYNC_URING
+    "uring",
 #endif
     "posix"
   )
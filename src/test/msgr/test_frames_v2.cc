@@ -245,6 +245,81 @@ TEST_P(RoundTripTest, Reuse) {
   }
 }
 
+// Same as RoundTripTest.Basic, but with the segments scattered over
+// many buffers, short and long ones mixed, as encoded messages are.
+TEST(FragmentedRoundTripTest, Basic) {
+  auto fragment = [](const bufferlist& bl) {
+    bufferlist out;
+    unsigned off = 0;
+    unsigned len = 1;
+    while (off < bl.length()) {
+      len = std::min(len, bl.length() - off);
+      bufferlist piece;
+      piece.substr_of(bl, off, len);
+      out.push_back(buffer::copy(piece.c_str(), len));
+      off += len;
+      len = len * 7 % 3000 + 1;
+    }
+    return out;
+  };
+
+  const auto header = make_bufferlist(49, 'H');
+  auto front = make_bufferlist(5000, 'F');
+  auto data = make_bufferlist(20000, 'D');
+  for (size_t i = 0; i < front.length(); i++) {
+    front.c_str()[i] += i % 13;
+  }
+  for (size_t i = 0; i < data.length(); i++) {
+    data.c_str()[i] += i % 11;
+  }
+
+  for (const auto& m : modes) {
+    SCOPED_TRACE(m);
+    ceph::crypto::onwire::rxtx_t tx_crypto;
+    ceph::crypto::onwire::rxtx_t rx_crypto;
+    if (m.is_secure) {
+      AuthConnectionMeta auth_meta;
+      auth_meta.con_mode = CEPH_CON_MODE_SECURE;
+      auth_meta.connection_secret.resize(64);
+      g_ceph_context->random()->get_bytes(auth_meta.connection_secret.data(),
+                                          auth_meta.connection_secret.size());
+      tx_crypto = ceph::crypto::onwire::rxtx_t::create_handler_pair(
+          g_ceph_context, auth_meta, /*new_nonce_format=*/m.is_rev1,
+          /*crossed=*/false);
+      rx_crypto = ceph::crypto::onwire::rxtx_t::create_handler_pair(
+          g_ceph_context, auth_meta, /*new_nonce_format=*/m.is_rev1,
+          /*crossed=*/true);
+    }
+    FrameAssembler tx_frame_asm(&tx_crypto, m.is_rev1);
+    FrameAssembler rx_frame_asm(&rx_crypto, m.is_rev1);
+
+    for (int i = 0; i < 3; i++) {
+      auto tx_frame = TestFrame::Encode(fragment(header), fragment(front),
+                                        bufferlist(), fragment(data));
+      auto onwire_bl = tx_frame.get_buffer(tx_frame_asm);
+
+      Tag rx_tag;
+      segment_bls_t rx_segment_bls;
+      ASSERT_TRUE(disassemble_frame(rx_frame_asm, onwire_bl, rx_tag,
+                                    rx_segment_bls));
+      EXPECT_EQ(0, onwire_bl.length());
+      auto rx_frame = TestFrame::Decode(rx_segment_bls);
+      EXPECT_TRUE(header.contents_equal(rx_frame.header()));
+      EXPECT_TRUE(front.contents_equal(rx_frame.front()));
+      EXPECT_EQ(0, rx_frame.middle().length());
+      EXPECT_TRUE(data.contents_equal(rx_frame.data()));
+    }
+
+    if (m.is_secure) {
+      // the time spent in the cipher is handed out once
+      EXPECT_GT(tx_crypto.tx->take_busy_time(), ceph::timespan::zero());
+      EXPECT_EQ(tx_crypto.tx->take_busy_time(), ceph::timespan::zero());
+      EXPECT_GT(rx_crypto.rx->take_busy_time(), ceph::timespan::zero());
+      EXPECT_EQ(rx_crypto.rx->take_busy_time(), ceph::timespan::zero());
+    }
+  }
+}
+
 static const round_trip_instance_t round_trip_instances[] = {
   // first segment is empty
   { 0,   0,   0,   0, 1, {{32,  0,  17,   0,   0,  0},
@@ -1579,6 +1579,371 @@ TEST_P(MessengerTest, MessageTest) {
 }
 
 
+class RxDataDispatcher : public FakeDispatcher {
+ public:
+  bool supply = false;
+  std::atomic<unsigned> supplied = 0;
+  std::atomic<unsigned> data_page_off = 0;
+
+  explicit RxDataDispatcher(bool s) : FakeDispatcher(s) {}
+
+  bool ms_alloc_rx_data(Connection *con, int type, unsigned data_off,
+                        unsigned len, bufferptr *bp) override {
+    if (!supply || type != CEPH_MSG_PING) {
+      return false;
+    }
+    *bp = buffer::create_page_aligned(len);
+    supplied++;
+    return true;
+  }
+  void ms_fast_dispatch(Message *m) override {
+    if (m->get_data().length()) {
+      data_page_off = reinterpret_cast<uintptr_t>(
+        m->get_data().front().c_str()) & ~CEPH_PAGE_MASK;
+    }
+    FakeDispatcher::ms_fast_dispatch(m);
+  }
+};
+
+TEST_P(MessengerTest, RxDataAllocTest) {
+  RxDataDispatcher cli_dispatcher(false), srv_dispatcher(true);
+  entity_addr_t bind_addr;
+  bind_addr.parse("v2:127.0.0.1");
+  Messenger::Policy p = Messenger::Policy::stateful_server(0);
+  server_msgr->set_policy(entity_name_t::TYPE_CLIENT, p);
+  p = Messenger::Policy::lossless_peer(0);
+  client_msgr->set_policy(entity_name_t::TYPE_OSD, p);
+
+  server_msgr->bind(bind_addr);
+  server_msgr->add_dispatcher_head(&srv_dispatcher);
+  server_msgr->start();
+  client_msgr->add_dispatcher_head(&cli_dispatcher);
+  client_msgr->start();
+
+  ConnectionRef conn = client_msgr->connect_to(server_msgr->get_mytype(),
+					       server_msgr->get_myaddrs());
+  auto send_ping = [&](unsigned data_off) {
+    bufferlist bl;
+    bl.append_zero(3 * CEPH_PAGE_SIZE);
+    MPing *m = new MPing();
+    m->set_data(bl);
+    m->get_header().data_off = data_off;
+    conn->send_message(m);
+    std::unique_lock l{cli_dispatcher.lock};
+    cli_dispatcher.cond.wait(l, [&] { return cli_dispatcher.got_new; });
+    cli_dispatcher.got_new = false;
+  };
+
+  // 1. the payload is laid out according to the sender's data_off
+  send_ping(CEPH_PAGE_SIZE + 512);
+  ASSERT_EQ(512u, srv_dispatcher.data_page_off);
+  ASSERT_EQ(0u, srv_dispatcher.supplied);
+
+  // 2. a Dispatcher can supply the buffer itself
+  srv_dispatcher.supply = true;
+  send_ping(512);
+  ASSERT_EQ(0u, srv_dispatcher.data_page_off);
+  ASSERT_EQ(1u, srv_dispatcher.supplied);
+
+  server_msgr->shutdown();
+  client_msgr->shutdown();
+  server_msgr->wait();
+  client_msgr->wait();
+}
+
+class InlineDispatcher : public FakeDispatcher {
+ public:
+  std::atomic<unsigned> dispatched_inline = 0;
+  std::atomic<unsigned> dispatched_queued = 0;
+
+  explicit InlineDispatcher(bool s) : FakeDispatcher(s) {}
+
+  bool ms_can_fast_dispatch(const Message *m) const override {
+    return false;
+  }
+  bool ms_dispatch(Message *m) override {
+    char name[16] = {0};
+    ceph_pthread_getname(pthread_self(), name, sizeof(name));
+    if (std::string_view(name).substr(0, 11) == "msgr-worker") {
+      dispatched_inline++;
+    } else {
+      dispatched_queued++;
+    }
+    return FakeDispatcher::ms_dispatch(m);
+  }
+};
+
+TEST_P(MessengerTest, InlineDispatchTest) {
+  // the option is read when the messengers are created
+  g_ceph_context->_conf.set_val("ms_dispatch_inline_types",
+                                std::to_string(CEPH_MSG_PING));
+  delete server_msgr;
+  delete client_msgr;
+  SetUp();
+  g_ceph_context->_conf.rm_val("ms_dispatch_inline_types");
+
+  InlineDispatcher cli_dispatcher(false), srv_dispatcher(true);
+  entity_addr_t bind_addr;
+  bind_addr.parse("v2:127.0.0.1");
+  server_msgr->bind(bind_addr);
+  server_msgr->add_dispatcher_head(&srv_dispatcher);
+  server_msgr->start();
+  client_msgr->add_dispatcher_head(&cli_dispatcher);
+  client_msgr->start();
+
+  ConnectionRef conn = client_msgr->connect_to(server_msgr->get_mytype(),
+					       server_msgr->get_myaddrs());
+  auto ping = [&] {
+    ASSERT_EQ(conn->send_message(new MPing()), 0);
+    std::unique_lock l{cli_dispatcher.lock};
+    cli_dispatcher.cond.wait(l, [&] { return cli_dispatcher.got_new; });
+    cli_dispatcher.got_new = false;
+  };
+  // the first one may race with the connect/accept notifications
+  // still being delivered by the dispatch thread
+  ping();
+  srv_dispatcher.dispatched_inline = srv_dispatcher.dispatched_queued = 0;
+  cli_dispatcher.dispatched_inline = cli_dispatcher.dispatched_queued = 0;
+
+  // with the dispatch thread idle, each ping and its reply are
+  // dispatched by the messenger thread that received them
+  for (int i = 0; i < 10; i++) {
+    ping();
+  }
+  ASSERT_EQ(10u, srv_dispatcher.dispatched_inline);
+  ASSERT_EQ(0u, srv_dispatcher.dispatched_queued);
+  ASSERT_EQ(10u, cli_dispatcher.dispatched_inline);
+  ASSERT_EQ(0u, cli_dispatcher.dispatched_queued);
+
+  server_msgr->shutdown();
+  client_msgr->shutdown();
+  server_msgr->wait();
+  client_msgr->wait();
+}
+
+class TidDispatcher : public FakeDispatcher {
+ public:
+  std::vector<ceph_tid_t> tids;
+
+  explicit TidDispatcher(bool s) : FakeDispatcher(s) {}
+
+  void ms_fast_dispatch(Message *m) override {
+    {
+      std::lock_guard l{lock};
+      tids.push_back(m->get_tid());
+    }
+    FakeDispatcher::ms_fast_dispatch(m);
+  }
+};
+
+struct WorkerCounters {
+  uint64_t send_bytes = 0;
+  uint64_t recv_bytes = 0;
+  uint64_t frames = 0;
+  uint64_t writes = 0;
+  uint64_t prefetch_bufs = 0;
+  uint64_t prefetch_bufs_allocated = 0;
+
+  static WorkerCounters get() {
+    WorkerCounters c;
+    g_ceph_context->get_perfcounters_collection()->with_counters(
+      [&c](const PerfCountersCollectionImpl::CounterMap& by_path) {
+	for (auto& [path, ref] : by_path) {
+	  if (path.rfind("AsyncMessenger::Worker-", 0) != 0) {
+	    continue;
+	  }
+	  auto name = std::string_view(path).substr(path.find('.') + 1);
+	  if (name == "msgr_send_bytes") {
+	    c.send_bytes += ref.data->u64;
+	  } else if (name == "msgr_recv_bytes") {
+	    c.recv_bytes += ref.data->u64;
+	  } else if (name == "msgr_send_frames_per_write") {
+	    auto [frames, writes] = ref.data->read_avg();
+	    c.frames += frames;
+	    c.writes += writes;
+	  } else if (name == "msgr_recv_prefetch_bufs") {
+	    c.prefetch_bufs += ref.data->u64;
+	  } else if (name == "msgr_recv_prefetch_bufs_allocated") {
+	    c.prefetch_bufs_allocated += ref.data->u64;
+	  }
+	}
+      });
+    return c;
+  }
+  WorkerCounters operator-(const WorkerCounters& rhs) const {
+    WorkerCounters c;
+    c.send_bytes = send_bytes - rhs.send_bytes;
+    c.recv_bytes = recv_bytes - rhs.recv_bytes;
+    c.frames = frames - rhs.frames;
+    c.writes = writes - rhs.writes;
+    c.prefetch_bufs = prefetch_bufs - rhs.prefetch_bufs;
+    c.prefetch_bufs_allocated =
+      prefetch_bufs_allocated - rhs.prefetch_bufs_allocated;
+    return c;
+  }
+};
+
+// Sends a burst of pings on a lossy connection to a server that does
+// not reply, so that the burst is all the messengers send meanwhile,
+// and returns what their workers counted for it.
+static void ping_burst(Messenger *server_msgr, Messenger *client_msgr,
+		       unsigned n, WorkerCounters *burst)
+{
+  TidDispatcher cli_dispatcher(false), srv_dispatcher(false);
+  entity_addr_t bind_addr;
+  bind_addr.parse("v2:127.0.0.1");
+  server_msgr->bind(bind_addr);
+  server_msgr->add_dispatcher_head(&srv_dispatcher);
+  server_msgr->start();
+  client_msgr->add_dispatcher_head(&cli_dispatcher);
+  client_msgr->start();
+
+  ConnectionRef conn = client_msgr->connect_to(server_msgr->get_mytype(),
+					       server_msgr->get_myaddrs());
+  // get the handshake out of the way
+  auto before = WorkerCounters::get();
+  ASSERT_EQ(0, conn->send_message(new MPing()));
+  {
+    std::unique_lock l{srv_dispatcher.lock};
+    srv_dispatcher.cond.wait(l, [&] { return srv_dispatcher.got_new; });
+  }
+  // the sender may count it after the receiver did
+  CHECK_AND_WAIT_TRUE([&before] {
+    auto d = WorkerCounters::get() - before;
+    return d.send_bytes == d.recv_bytes;
+  }());
+
+  before = WorkerCounters::get();
+  for (unsigned i = 1; i <= n; i++) {
+    MPing *m = new MPing();
+    m->set_tid(i);
+    ASSERT_EQ(0, conn->send_message(m));
+  }
+  {
+    std::unique_lock l{srv_dispatcher.lock};
+    srv_dispatcher.cond.wait(l, [&] {
+      return srv_dispatcher.tids.size() == n + 1;
+    });
+  }
+  CHECK_AND_WAIT_TRUE((WorkerCounters::get() - before).frames == n);
+  *burst = WorkerCounters::get() - before;
+
+  // in the order they were sent
+  for (unsigned i = 0; i <= n; i++) {
+    ASSERT_EQ(i, srv_dispatcher.tids[i]);
+  }
+
+  server_msgr->shutdown();
+  client_msgr->shutdown();
+  server_msgr->wait();
+  client_msgr->wait();
+}
+
+TEST_P(MessengerTest, WriteCoalesceTest) {
+  WorkerCounters burst;
+  ASSERT_NO_FATAL_FAILURE(ping_burst(server_msgr, client_msgr, 1000, &burst));
+  ASSERT_EQ(1000u, burst.frames);
+  // the pings queued behind one another went out together
+  ASSERT_LT(burst.writes, burst.frames);
+  // and every byte of them was accounted for, whichever write sent it
+  ASSERT_EQ(burst.recv_bytes, burst.send_bytes);
+}
+
+TEST_P(MessengerTest, WriteCoalesceDisabledTest) {
+  // read when a connection is created
+  g_ceph_context->_conf.set_val("ms_async_write_coalesce_bytes", "0");
+  WorkerCounters burst;
+  ping_burst(server_msgr, client_msgr, 1000, &burst);
+  g_ceph_context->_conf.rm_val("ms_async_write_coalesce_bytes");
+  ASSERT_FALSE(HasFatalFailure());
+  // one write per message
+  ASSERT_EQ(1000u, burst.frames);
+  ASSERT_EQ(burst.frames, burst.writes);
+  ASSERT_EQ(burst.recv_bytes, burst.send_bytes);
+}
+
+TEST_P(MessengerTest, RecvPrefetchBufTest) {
+  TidDispatcher cli_dispatcher(false), srv_dispatcher(false);
+  entity_addr_t bind_addr;
+  bind_addr.parse("v2:127.0.0.1");
+  Messenger::Policy p = Messenger::Policy::stateful_server(0);
+  server_msgr->set_policy(entity_name_t::TYPE_CLIENT, p);
+  p = Messenger::Policy::lossless_peer(0);
+  client_msgr->set_policy(entity_name_t::TYPE_OSD, p);
+
+  server_msgr->bind(bind_addr);
+  server_msgr->add_dispatcher_head(&srv_dispatcher);
+  server_msgr->start();
+  client_msgr->add_dispatcher_head(&cli_dispatcher);
+  client_msgr->start();
+
+  // the workers are shared with whatever the earlier tests left behind
+  auto before = WorkerCounters::get();
+  auto lent = [&before] {
+    return (WorkerCounters::get() - before).prefetch_bufs;
+  };
+  auto send_pings = [&](ConnectionRef conn, unsigned n, unsigned data_len) {
+    size_t sent = srv_dispatcher.tids.size() + n;
+    for (unsigned i = 0; i < n; i++) {
+      MPing *m = new MPing();
+      if (data_len) {
+	bufferlist bl;
+	bl.append_zero(data_len);
+	m->set_data(bl);
+      }
+      ASSERT_EQ(0, conn->send_message(m));
+    }
+    std::unique_lock l{srv_dispatcher.lock};
+    srv_dispatcher.cond.wait(l, [&] {
+      return srv_dispatcher.tids.size() == sent;
+    });
+  };
+
+  // 1. a burst of small frames: they arrive several to a read, so the
+  // buffer outlives the read_until() calls that each consume only part
+  // of it, and is given back once all of it has been
+  ConnectionRef conn = client_msgr->connect_to(server_msgr->get_mytype(),
+					       server_msgr->get_myaddrs());
+  auto burst = WorkerCounters::get();
+  ASSERT_NO_FATAL_FAILURE(send_pings(conn, 1000, 0));
+  burst = WorkerCounters::get() - burst;
+  ASSERT_LT(burst.writes, burst.frames);
+  CHECK_AND_WAIT_TRUE(lent() == 0);
+  ASSERT_EQ(0u, lent());
+  // each end holds at most one at a time, and then takes it from the pool
+  ASSERT_LE((WorkerCounters::get() - before).prefetch_bufs_allocated, 2u);
+
+  // 2. segments larger than the prefetch size are read in place
+  ASSERT_NO_FATAL_FAILURE(send_pings(conn, 10, 1 << 20));
+  CHECK_AND_WAIT_TRUE(lent() == 0);
+  ASSERT_EQ(0u, lent());
+  ASSERT_LE((WorkerCounters::get() - before).prefetch_bufs_allocated, 2u);
+
+  // 3. the server fails to read from the socket the client closed
+  conn->mark_down();
+  CHECK_AND_WAIT_TRUE(lent() == 0);
+  ASSERT_EQ(0u, lent());
+
+  // 4. new connections pick up a new ms_tcp_prefetch_max_size, and the
+  // pooled buffers of the old size are not handed out to them
+  g_ceph_context->_conf.set_val("ms_tcp_prefetch_max_size", "8192");
+  auto allocated = WorkerCounters::get().prefetch_bufs_allocated;
+  conn = client_msgr->connect_to(server_msgr->get_mytype(),
+				 server_msgr->get_myaddrs());
+  send_pings(conn, 1000, 0);
+  g_ceph_context->_conf.rm_val("ms_tcp_prefetch_max_size");
+  ASSERT_FALSE(HasFatalFailure());
+  ASSERT_GT(WorkerCounters::get().prefetch_bufs_allocated, allocated);
+  CHECK_AND_WAIT_TRUE(lent() == 0);
+  ASSERT_EQ(0u, lent());
+
+  server_msgr->shutdown();
+  client_msgr->shutdown();
+  server_msgr->wait();
+  client_msgr->wait();
+}
+
+
 class SyntheticWorkload;
 
 struct Payload {
@@ -2333,6 +2698,9 @@ INSTANTIATE_TEST_SUITE_P(
   Messenger,
   MessengerTest,
   ::testing::Values(
+#ifdef HAVE_ASYNC_URING
+    "async+uring",
+#endif
     "async+posix"
   )
 );
@@ -58,3 +58,50 @@ TEST(ECUtil, stripe_info_t)
             make_pair((uint64_t)0, 2*swidth));
 }
 
+
+TEST(ECBackend, is_subchunk_read)
+{
+  const int sub_chunk_count = 8;
+  map<pg_shard_t, vector<pair<int, int>>> need;
+  need[pg_shard_t(1, shard_id_t(1))].push_back(make_pair(0, sub_chunk_count));
+  need[pg_shard_t(2, shard_id_t(2))].push_back(make_pair(0, sub_chunk_count));
+  ASSERT_FALSE(ECBackend::is_subchunk_read(need, sub_chunk_count));
+  // codecs without sub-chunks always read whole chunks
+  map<pg_shard_t, vector<pair<int, int>>> whole;
+  whole[pg_shard_t(1, shard_id_t(1))].push_back(make_pair(0, 1));
+  ASSERT_FALSE(ECBackend::is_subchunk_read(whole, 1));
+
+  // clay repair: a few runs of sub-chunks from each helper
+  need[pg_shard_t(3, shard_id_t(3))] = {make_pair(0, 2), make_pair(4, 2)};
+  ASSERT_TRUE(ECBackend::is_subchunk_read(need, sub_chunk_count));
+  need[pg_shard_t(3, shard_id_t(3))] = {make_pair(2, 6)};
+  ASSERT_TRUE(ECBackend::is_subchunk_read(need, sub_chunk_count));
+  need.erase(pg_shard_t(3, shard_id_t(3)));
+  ASSERT_FALSE(ECBackend::is_subchunk_read(need, sub_chunk_count));
+}
+
+TEST(ECBackend, discard_subchunk_reads)
+{
+  // two helpers returned their repair sub-chunks, a third one failed
+  ECBackend::read_result_t result;
+  map<pg_shard_t, bufferlist> returned;
+  returned[pg_shard_t(1, shard_id_t(1))].append_zero(1024);
+  returned[pg_shard_t(2, shard_id_t(2))].append_zero(512);
+  result.returned.push_back(
+    boost::make_tuple(0, 8192, std::move(returned)));
+  result.errors[pg_shard_t(3, shard_id_t(3))] = -EIO;
+
+  set<int> skip;
+  ASSERT_EQ(1536u, ECBackend::discard_subchunk_reads(result, &skip));
+  // the retry reads whole chunks from every shard but the failed one,
+  // including the helpers whose sub-chunks were dropped
+  ASSERT_EQ(set<int>{3}, skip);
+  ASSERT_EQ(1u, result.returned.size());
+  ASSERT_EQ(0u, result.returned.front().get<0>());
+  ASSERT_EQ(8192u, result.returned.front().get<1>());
+  ASSERT_TRUE(result.returned.front().get<2>().empty());
+  ASSERT_EQ(1u, result.errors.size());
+
+  // nothing left to discard the second time around
+  ASSERT_EQ(0u, ECBackend::discard_subchunk_reads(result, &skip));
+}
@@ -1118,6 +1118,148 @@ TEST_F(OSDMapTest, CleanPGUpmaps) {
   }
 }
 
+TEST_F(OSDMapTest, IncrementalMapping) {
+  set_up_map();
+  mapping.update(osdmap);
+  const pg_pool_t *pool = osdmap.get_pg_pool(my_rep_pool);
+  ASSERT_TRUE(pool);
+
+  auto check_all = [&]() {
+    OSDMapMapping full;
+    full.update(osdmap);
+    for (auto& p : osdmap.get_pools()) {
+      for (unsigned ps = 0; ps < p.second.get_pg_num(); ++ps) {
+	pg_t pgid(ps, p.first);
+	vector<int> up, acting, up2, acting2;
+	int up_primary, acting_primary, up_primary2, acting_primary2;
+	full.get(pgid, &up, &up_primary, &acting, &acting_primary);
+	mapping.get(pgid, &up2, &up_primary2, &acting2, &acting_primary2);
+	ASSERT_EQ(up, up2) << pgid;
+	ASSERT_EQ(up_primary, up_primary2) << pgid;
+	ASSERT_EQ(acting, acting2) << pgid;
+	ASSERT_EQ(acting_primary, acting_primary2) << pgid;
+      }
+    }
+  };
+
+  {
+    // mark osd.0 down, pg_temp and upmap a pg each
+    OSDMap::Incremental pending_inc(osdmap.get_epoch() + 1);
+    pending_inc.new_state[0] = CEPH_OSD_UP;
+    pending_inc.new_pg_temp[pg_t(1, my_rep_pool)] =
+      mempool::osdmap::vector<int32_t>{3, 4, 5};
+    pending_inc.new_pg_upmap_items[pg_t(2, my_rep_pool)] =
+      mempool::osdmap::vector<pair<int32_t,int32_t>>{{1, 2}};
+    pending_inc.new_primary_affinity[3] = 0;
+    osdmap.apply_incremental(pending_inc);
+    set<pg_t> pgs;
+    ASSERT_TRUE(osdmap.get_incremental_mapping_pgs(pending_inc, mapping, &pgs));
+    ASSERT_TRUE(pgs.count(pg_t(1, my_rep_pool)));
+    ASSERT_TRUE(pgs.count(pg_t(2, my_rep_pool)));
+    ASSERT_LT(pgs.size(), mapping.get_num_pgs());
+    mapping.update(osdmap, pgs);
+    ASSERT_EQ(osdmap.get_epoch(), mapping.get_epoch());
+    check_all();
+  }
+  {
+    // bringing it back up can move anything
+    OSDMap::Incremental pending_inc(osdmap.get_epoch() + 1);
+    pending_inc.new_up_client[0] = osdmap.get_addrs(0);
+    osdmap.apply_incremental(pending_inc);
+    set<pg_t> pgs;
+    ASSERT_FALSE(osdmap.get_incremental_mapping_pgs(pending_inc, mapping,
+						      &pgs));
+  }
+}
+
+TEST_F(OSDMapTest, PGMovementPreview) {
+  set_up_map();
+  OSDMap tmpmap;
+  tmpmap.deepish_copy_from(osdmap);
+  OSDMap::Incremental pending_inc(tmpmap.get_epoch() + 1);
+  pending_inc.new_weight[0] = CEPH_OSD_OUT;
+  tmpmap.apply_incremental(pending_inc);
+
+  ThreadPool tp(g_ceph_context, "PGMovementPreview", "tp_preview", 4);
+  tp.start();
+  ParallelPGMapper mapper(g_ceph_context, &tp);
+  PGMovementPreview preview;
+  preview.compute(osdmap, tmpmap, mapper, 64);
+  tp.stop();
+
+  uint64_t total_pgs = 0;
+  for (auto& p : osdmap.get_pools())
+    total_pgs += p.second.get_pg_num();
+  ASSERT_EQ(total_pgs, preview.num_pgs);
+  ASSERT_FALSE(preview.moves.empty());
+
+  // only pgs that were on osd.0 move, and each loses that copy
+  std::map<pg_t,uint64_t> pg_bytes;
+  uint64_t expected_bytes = 0;
+  for (auto& [pgid, m] : preview.moves) {
+    ASSERT_NE(m.from.end(), std::find(m.from.begin(), m.from.end(), 0));
+    ASSERT_EQ(m.to.end(), std::find(m.to.begin(), m.to.end(), 0));
+    if (pgid.pool() == my_ec_pool) {
+      ASSERT_LE(m.shards, 1u);
+      ASSERT_LT(1u, m.data_shards);
+    } else {
+      ASSERT_LE(1u, m.shards);
+      ASSERT_EQ(1u, m.data_shards);
+    }
+    pg_bytes[pgid] = 1 << 20;
+    expected_bytes += (1 << 20) / m.data_shards * m.shards;
+  }
+  for (unsigned ps = 0; ps < osdmap.get_pg_num(my_rep_pool); ++ps) {
+    pg_t pgid(ps, my_rep_pool);
+    vector<int> up;
+    osdmap.pg_to_up_acting_osds(pgid, &up, nullptr, nullptr, nullptr);
+    bool had_osd0 = std::find(up.begin(), up.end(), 0) != up.end();
+    ASSERT_EQ(had_osd0, preview.moves.count(pgid) == 1);
+  }
+
+  uint64_t unknown = 0;
+  ASSERT_EQ(expected_bytes, preview.estimate_bytes(pg_bytes, &unknown));
+  ASSERT_EQ(0u, unknown);
+  pg_bytes.erase(std::find_if(
+    preview.moves.begin(), preview.moves.end(),
+    [](auto& i) { return i.second.shards > 0; })->first);
+  preview.estimate_bytes(pg_bytes, &unknown);
+  ASSERT_EQ(1u, unknown);
+}
+
+TEST_F(OSDMapTest, DedupSharesUpmaps) {
+  set_up_map();
+  const unsigned num_upmaps = 1000;
+  {
+    OSDMap::Incremental pending_inc(osdmap.get_epoch() + 1);
+    for (unsigned i = 0; i < num_upmaps; ++i) {
+      pending_inc.new_pg_upmap_items[pg_t(i, my_rep_pool)] =
+	mempool::osdmap::vector<pair<int32_t,int32_t>>{{0, 1}};
+    }
+    osdmap.apply_incremental(pending_inc);
+  }
+  // the next epoch leaves the upmaps alone
+  OSDMap next;
+  next.deepish_copy_from(osdmap);
+  {
+    OSDMap::Incremental pending_inc(next.get_epoch() + 1);
+    pending_inc.new_weight[0] = CEPH_OSD_IN / 2;
+    next.apply_incremental(pending_inc);
+  }
+  bufferlist bl;
+  next.encode(bl);
+  auto decoded = std::make_unique<OSDMap>();
+  decoded->decode(bl);
+
+  size_t before = mempool::osdmap::allocated_items();
+  OSDMap::dedup(&osdmap, decoded.get());
+  size_t after = mempool::osdmap::allocated_items();
+  // one tree node and one vector per entry went away
+  ASSERT_GE(before - after, 2 * num_upmaps);
+  ASSERT_TRUE(decoded->have_pg_upmaps(pg_t(0, my_rep_pool)));
+  ASSERT_EQ(CEPH_OSD_IN / 2, decoded->get_weight(0));
+}
+
 TEST_F(OSDMapTest, BUG_38897) {
   // http://tracker.ceph.com/issues/38897
   // build a fresh map with 12 OSDs, without any default pools
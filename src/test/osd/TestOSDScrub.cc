@@ -146,6 +146,38 @@ TEST(TestOSDScrub, scrub_time_permit) {
 
 }
 
+TEST(TestOSDScrub, step_latency_throttle) {
+  const unsigned max = OSDService::SCRUB_THROTTLE_MAX_LEVEL;
+  const double target = 0.1;
+
+  // disabled: always unthrottled
+  ASSERT_EQ(0u, OSDService::step_latency_throttle(5, max, 100, 1.0, 0));
+
+  // idle: back off one level per tick, down to 0
+  ASSERT_EQ(4u, OSDService::step_latency_throttle(5, max, 0, 0, target));
+  ASSERT_EQ(0u, OSDService::step_latency_throttle(0, max, 0, 0, target));
+
+  // over target: throttle harder, up to the max level
+  ASSERT_EQ(1u, OSDService::step_latency_throttle(0, max, 100, 0.2, target));
+  ASSERT_EQ(max, OSDService::step_latency_throttle(max - 1, max, 100, 0.2,
+						   target));
+  ASSERT_EQ(max, OSDService::step_latency_throttle(max, max, 100, 0.2,
+						   target));
+  unsigned level = 0;
+  for (unsigned i = 0; i < 2 * max; i++) {
+    level = OSDService::step_latency_throttle(level, max, 100, 1.0, target);
+  }
+  ASSERT_EQ(max, level);
+
+  // between target/2 and target: hold
+  ASSERT_EQ(3u, OSDService::step_latency_throttle(3, max, 100, 0.07, target));
+  ASSERT_EQ(3u, OSDService::step_latency_throttle(3, max, 100, 0.1, target));
+
+  // under target/2: relax, down to 0
+  ASSERT_EQ(2u, OSDService::step_latency_throttle(3, max, 100, 0.04, target));
+  ASSERT_EQ(0u, OSDService::step_latency_throttle(0, max, 100, 0.04, target));
+}
+
 // Local Variables:
 // compile-command: "cd ../.. ; make unittest_osdscrub ; ./unittest_osdscrub --log-to-stderr=true  --debug-osd=20 # --gtest_filter=*.* "
 // End:
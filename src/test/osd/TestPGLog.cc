@@ -2673,6 +2673,105 @@ TEST_F(PGLogMergeDupsTest, Superset) {
 }
 
 
+class PGLogWriteTrimTest : protected PGLog,
+			   public PGLogTestBase,
+			   public StoreTestFixture {
+public:
+  PGLogWriteTrimTest() : PGLog(g_ceph_context), StoreTestFixture("memstore") {}
+
+  void SetUp() override {
+    StoreTestFixture::SetUp();
+    ObjectStore::Transaction t;
+    test_coll = coll_t(spg_t(pg_t(1, 1)));
+    ch = store->create_new_collection(test_coll);
+    t.create_collection(test_coll, 0);
+    store->queue_transaction(ch, std::move(t));
+    hobject_t hoid;
+    hoid.pool = 1;
+    hoid.oid = "log";
+    log_oid = ghobject_t(hoid);
+    orig_dups_tracked = g_ceph_context->_conf->osd_pg_log_dups_tracked;
+  }
+
+  void TearDown() override {
+    g_ceph_context->_conf.set_val_or_die(
+      "osd_pg_log_dups_tracked", std::to_string(orig_dups_tracked));
+    StoreTestFixture::TearDown();
+  }
+
+  void set_dups_tracked(unsigned n) {
+    g_ceph_context->_conf.set_val_or_die(
+      "osd_pg_log_dups_tracked", std::to_string(n));
+  }
+
+  void write() {
+    ObjectStore::Transaction t;
+    map<string, bufferlist> km;
+    write_log_and_missing(t, &km, test_coll, log_oid, false);
+    if (!km.empty()) {
+      t.omap_setkeys(test_coll, log_oid, km);
+    }
+    ASSERT_EQ(0, store->queue_transaction(ch, std::move(t)));
+  }
+
+  void get_keys(set<string> *log_keys, set<string> *dup_keys) {
+    set<string> keys;
+    ASSERT_EQ(0, store->omap_get_keys(ch, log_oid, &keys));
+    for (auto& k : keys) {
+      if (k[0] >= '0' && k[0] <= '9') {
+	log_keys->insert(k);
+      } else if (k.compare(0, 4, "dup_") == 0) {
+	dup_keys->insert(k);
+      }
+    }
+  }
+
+  coll_t test_coll;
+  ghobject_t log_oid;
+  uint64_t orig_dups_tracked = 0;
+};
+
+TEST_F(PGLogWriteTrimTest, TrimRemovesKeyRanges) {
+  osd_reqid_t reqid(entity_name_t::CLIENT(777), 8, 0);
+  for (unsigned i = 1; i <= 10; ++i) {
+    reqid.tid = i;
+    add(mk_ple_mod(mk_obj(i), mk_evt(10, i), mk_evt(10, i - 1), reqid));
+  }
+  log.skip_can_rollback_to_to_head();
+  write();
+
+  set<string> log_keys, dup_keys;
+  get_keys(&log_keys, &dup_keys);
+  EXPECT_EQ(10u, log_keys.size());
+  EXPECT_EQ(0u, dup_keys.size());
+
+  // entries 5 and 6 become dups, 1-4 are dropped
+  set_dups_tracked(6);
+  pg_info_t info;
+  trim(mk_evt(10, 6), info, false, false);
+  write();
+
+  log_keys.clear();
+  dup_keys.clear();
+  get_keys(&log_keys, &dup_keys);
+  EXPECT_EQ(4u, log_keys.size());
+  EXPECT_EQ(mk_evt(10, 7).get_key_name(), *log_keys.begin());
+  EXPECT_EQ(2u, dup_keys.size());
+
+  // entry 8 becomes a dup, 7 is dropped and the 5 and 6 dups are trimmed
+  set_dups_tracked(3);
+  trim(mk_evt(10, 8), info, false, false);
+  write();
+
+  log_keys.clear();
+  dup_keys.clear();
+  get_keys(&log_keys, &dup_keys);
+  EXPECT_EQ(set<string>({mk_evt(10, 9).get_key_name(),
+			 mk_evt(10, 10).get_key_name()}), log_keys);
+  ASSERT_EQ(1u, log.dups.size());
+  EXPECT_EQ(set<string>({log.dups.front().get_key_name()}), dup_keys);
+}
+
 struct PGLogTrimTest :
   public ::testing::Test,
   public PGLogTestBase,
@@ -2983,6 +3082,63 @@ TEST(pg_log_dup_t, get_key_name) {
   EXPECT_EQ("dup_0000001234.00000000000000005678", a_key_name);
 }
 
+TEST(PGLogDupIndex, InsertFindErase) {
+  // a single client issuing sequential tids is the common case, and also
+  // the worst one for std::hash<osd_reqid_t>
+  const unsigned num_dups = 3000;
+  std::list<pg_log_dup_t> dups;
+  for (unsigned i = 0; i < num_dups; ++i) {
+    dups.emplace_back(eversion_t(1, i + 1), i + 1,
+		      osd_reqid_t(entity_name_t::CLIENT(777), 8, i), 0);
+  }
+
+  size_t before = mempool::osd_pglog::allocated_bytes();
+  PGLog::DupIndex index;
+  index.reserve(dups.size());
+  for (auto& d : dups) {
+    index.insert(&d);
+  }
+  ASSERT_EQ(num_dups, index.size());
+  // one pointer per slot at a load factor above 1/2
+  size_t used = mempool::osd_pglog::allocated_bytes() - before;
+  EXPECT_LE(used, num_dups * 2 * sizeof(pg_log_dup_t*));
+  std::cout << "dup index: " << used << " bytes for " << num_dups
+	    << " dups" << std::endl;
+
+  for (auto& d : dups) {
+    ASSERT_EQ(&d, index.find(d.reqid));
+  }
+  EXPECT_EQ(nullptr,
+	    index.find(osd_reqid_t(entity_name_t::CLIENT(778), 8, 1)));
+
+  // re-inserting a reqid replaces the entry
+  pg_log_dup_t again(eversion_t(2, 1), 1, dups.front().reqid, 0);
+  index.insert(&again);
+  EXPECT_EQ(num_dups, index.size());
+  EXPECT_EQ(&again, index.find(again.reqid));
+
+  // erase every other dup and make sure the rest remain reachable
+  unsigned n = 0;
+  for (auto& d : dups) {
+    if (n++ % 2) {
+      index.erase(d.reqid);
+    }
+  }
+  EXPECT_EQ(num_dups / 2, index.size());
+  n = 0;
+  for (auto& d : dups) {
+    if (n++ % 2) {
+      EXPECT_EQ(0u, index.count(d.reqid));
+    } else {
+      EXPECT_EQ(1u, index.count(d.reqid));
+    }
+  }
+
+  index.clear();
+  EXPECT_TRUE(index.empty());
+  EXPECT_EQ(nullptr, index.find(dups.back().reqid));
+}
+
 
 // This tests trim() to make copies of
 // 2 log entries (107, 106) and 3 additional for a total
@@ -0,0 +1,234 @@
+// -*- mode:C++; tab-width:8; c-basic-offset:2; indent-tabs-mode:t -*-
+// vim: ts=8 sw=2 smarttab
+/*
+ * Ceph - scalable distributed file system
+ *
+ * This is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License version 2.1, as published by the Free Software
+ * Foundation.  See file COPYING.
+ *
+ */
+
+#include <random>
+#include <gtest/gtest.h>
+#include "os/ObjectStore.h"
+#include "osd/ReplicatedBackend.h"
+#include "test/objectstore/store_test_fixture.h"
+
+using namespace std;
+
+TEST(ReplicatedBackend, partial_recovery_saved_bytes)
+{
+  const uint64_t size = 4 << 20;
+  ObjectRecoveryInfo ri;
+  ri.soid.oid = "obj";
+  ri.size = size;
+  ri.object_exist = true;
+
+  // full object: the whole thing is pushed
+  ri.copy_subset.insert(0, size);
+  ASSERT_EQ(0u, ReplicatedBackend::partial_recovery_saved_bytes(ri));
+
+  // partially dirty: only the dirty regions are pushed
+  ri.copy_subset.clear();
+  ri.copy_subset.insert(0, 4096);
+  ri.copy_subset.insert(1 << 20, 8192);
+  ASSERT_EQ(size - 12288,
+	    ReplicatedBackend::partial_recovery_saved_bytes(ri));
+
+  // dirty regions past the end of a truncated object don't count
+  ri.copy_subset.insert(size - 4096, 16384);
+  ASSERT_EQ(size - 16384,
+	    ReplicatedBackend::partial_recovery_saved_bytes(ri));
+
+  // only the omap changed: no data is pushed at all, the saving is
+  // data only
+  ri.copy_subset.clear();
+  ASSERT_EQ(size, ReplicatedBackend::partial_recovery_saved_bytes(ri));
+
+  // the target has no copy, so nothing is saved whatever is pushed
+  ri.object_exist = false;
+  ASSERT_EQ(0u, ReplicatedBackend::partial_recovery_saved_bytes(ri));
+
+  // size not known yet (first pull), or empty object
+  ri.object_exist = true;
+  ri.size = (uint64_t)-1;
+  ASSERT_EQ(0u, ReplicatedBackend::partial_recovery_saved_bytes(ri));
+  ri.size = 0;
+  ASSERT_EQ(0u, ReplicatedBackend::partial_recovery_saved_bytes(ri));
+}
+
+TEST(ReplicatedBackend, block_hash_random_writes)
+{
+  // a replica missed some random 4K writes to an rbd sized object and
+  // nothing narrowed the push down (e.g. backfill): a full push sends
+  // the whole object, comparing 64K block hashes only what changed
+  const uint64_t object_size = 4 << 20;
+  const uint32_t block_size = 64 << 10;
+  const uint64_t write_size = 4096;
+  std::mt19937 gen(0);
+  auto random_bytes = [&gen](size_t len) {
+    string s(len, 0);
+    for (auto& c : s) {
+      c = gen();
+    }
+    return s;
+  };
+  const string old_data = random_bytes(object_size);
+  std::uniform_int_distribution<uint64_t> pick(
+    0, object_size / write_size - 1);
+
+  for (unsigned nwrites : {1u, 8u, 32u, 128u}) {
+    string new_data = old_data;
+    set<uint64_t> changed_blocks;
+    for (unsigned i = 0; i < nwrites; ++i) {
+      uint64_t off = pick(gen) * write_size;
+      new_data.replace(off, write_size, random_bytes(write_size));
+      changed_blocks.insert(off / block_size);
+    }
+    bufferlist ours_bl, theirs_bl;
+    ours_bl.append(new_data);
+    theirs_bl.append(old_data);
+    vector<uint64_t> ours, theirs;
+    ReplicatedBackend::calc_block_hashes(ours_bl, block_size, &ours);
+    ReplicatedBackend::calc_block_hashes(theirs_bl, block_size, &theirs);
+    ASSERT_EQ(object_size / block_size, ours.size());
+
+    interval_set<uint64_t> copy_subset;
+    copy_subset.insert(0, object_size);
+    uint64_t saved = ReplicatedBackend::skip_matching_blocks(
+      block_size, ours, theirs, &copy_subset);
+    // exactly the blocks that were written are pushed
+    ASSERT_EQ(changed_blocks.size() * block_size, copy_subset.size());
+    ASSERT_EQ(object_size, saved + copy_subset.size());
+    for (auto p = copy_subset.begin(); p != copy_subset.end(); ++p) {
+      for (uint64_t b = p.get_start(); b < p.get_end(); b += block_size) {
+	ASSERT_TRUE(changed_blocks.count(b / block_size));
+      }
+    }
+    // and the target ends up with the primary's data
+    string rebuilt = old_data;
+    for (auto p = copy_subset.begin(); p != copy_subset.end(); ++p) {
+      rebuilt.replace(p.get_start(), p.get_len(),
+		      new_data, p.get_start(), p.get_len());
+    }
+    ASSERT_EQ(new_data, rebuilt);
+  }
+}
+
+TEST(ReplicatedBackend, block_hash_partial_copies)
+{
+  const uint32_t block_size = 4096;
+  bufferlist ours_bl, theirs_bl;
+  ours_bl.append(string(8 * block_size + 100, 'a'));
+  // the target's copy is shorter, and its 3rd block differs
+  theirs_bl.append(string(2 * block_size, 'a'));
+  theirs_bl.append(string(block_size, 'b'));
+  theirs_bl.append(string(2 * block_size + 10, 'a'));
+  vector<uint64_t> ours, theirs;
+  ReplicatedBackend::calc_block_hashes(ours_bl, block_size, &ours);
+  ReplicatedBackend::calc_block_hashes(theirs_bl, block_size, &theirs);
+  // partial tail blocks are not hashed
+  ASSERT_EQ(8u, ours.size());
+  ASSERT_EQ(5u, theirs.size());
+
+  interval_set<uint64_t> copy_subset, expected;
+  copy_subset.insert(0, ours_bl.length());
+  ASSERT_EQ(4u * block_size, ReplicatedBackend::skip_matching_blocks(
+	      block_size, ours, theirs, &copy_subset));
+  expected.insert(2 * block_size, block_size);
+  expected.insert(5 * block_size, 3 * block_size + 100);
+  ASSERT_EQ(expected, copy_subset);
+
+  // only what was going to be pushed anyway can be skipped
+  copy_subset.clear();
+  copy_subset.insert(block_size / 2, block_size);
+  copy_subset.insert(6 * block_size, 100);
+  ASSERT_EQ(block_size, ReplicatedBackend::skip_matching_blocks(
+	      block_size, ours, theirs, &copy_subset));
+  expected.clear();
+  expected.insert(6 * block_size, 100);
+  ASSERT_EQ(expected, copy_subset);
+
+  // a target without a copy sends no hashes, and everything is pushed
+  copy_subset.clear();
+  copy_subset.insert(0, ours_bl.length());
+  ASSERT_EQ(0u, ReplicatedBackend::skip_matching_blocks(
+	      block_size, ours, {}, &copy_subset));
+  ASSERT_EQ(ours_bl.length(), copy_subset.size());
+}
+
+class ReplicatedBackendPushTest : public StoreTestFixture {
+public:
+  coll_t cid;
+
+  ReplicatedBackendPushTest() : StoreTestFixture("memstore") {}
+
+  void SetUp() override {
+    StoreTestFixture::SetUp();
+    cid = coll_t(spg_t(pg_t(1, 1)));
+    ch = store->create_new_collection(cid);
+    ObjectStore::Transaction t;
+    t.create_collection(cid, 0);
+    ASSERT_EQ(0, store->queue_transaction(ch, std::move(t)));
+  }
+
+  void TearDown() override {
+    ch.reset();
+    StoreTestFixture::TearDown();
+  }
+
+  hobject_t make_object(const string& name, bool with_omap) {
+    hobject_t hoid(object_t(name), "", CEPH_NOSNAP, 0, 1, "");
+    ObjectStore::Transaction t;
+    t.touch(cid, ghobject_t(hoid));
+    if (with_omap) {
+      bufferlist header;
+      header.append("header");
+      t.omap_setheader(cid, ghobject_t(hoid), header);
+      map<string, bufferlist> kv;
+      kv["key"].append("value");
+      t.omap_setkeys(cid, ghobject_t(hoid), kv);
+    }
+    EXPECT_EQ(0, store->queue_transaction(ch, std::move(t)));
+    return hoid;
+  }
+};
+
+TEST_F(ReplicatedBackendPushTest, read_push_omap_header)
+{
+  {
+    hobject_t hoid = make_object("with_omap", true);
+    object_info_t oi(hoid);
+    oi.set_flag(object_info_t::FLAG_OMAP);
+    PushOp op;
+    ObjectRecoveryProgress progress;
+    ASSERT_EQ(0, ReplicatedBackend::read_push_omap_header(
+		store.get(), ch, hoid, oi, &op, &progress));
+    ASSERT_EQ(string("header"), op.omap_header.to_str());
+    // the entries still need to be pushed
+    ASSERT_FALSE(progress.omap_complete);
+  }
+  {
+    hobject_t hoid = make_object("no_omap", false);
+    object_info_t oi(hoid);
+    PushOp op;
+    ObjectRecoveryProgress progress;
+    ASSERT_EQ(0, ReplicatedBackend::read_push_omap_header(
+		store.get(), ch, hoid, oi, &op, &progress));
+    ASSERT_EQ(0u, op.omap_header.length());
+    // no omap iterator will be created for it
+    ASSERT_TRUE(progress.omap_complete);
+  }
+  {
+    // an object claiming omap that the store doesn't have fails the push
+    hobject_t hoid(object_t("missing"), "", CEPH_NOSNAP, 0, 1, "");
+    object_info_t oi(hoid);
+    oi.set_flag(object_info_t::FLAG_OMAP);
+    PushOp op;
+    ObjectRecoveryProgress progress;
+    ASSERT_GT(0, ReplicatedBackend::read_push_omap_header(
+		store.get(), ch, hoid, oi, &op, &progress));
+  }
+}
@@ -23,6 +23,7 @@
 #include "common/Thread.h"
 #include "include/stringify.h"
 #include "osd/ReplicatedBackend.h"
+#include "osd/recovery_types.h"
 #include <sstream>
 
 TEST(hobject, prefixes0)
@@ -2028,6 +2029,83 @@ TEST(chunk_info_test, calc_refs_g_l_match_no_this) {
 
 }
 
+static hobject_t mk_obj(unsigned id) {
+  hobject_t hoid;
+  stringstream ss;
+  ss << "obj_" << id;
+  hoid.oid = ss.str();
+  hoid.set_hash(id);
+  hoid.pool = 1;
+  return hoid;
+}
+
+TEST(BackfillPrefetch, use_prefetched)
+{
+  BackfillPrefetch pf;
+  pg_shard_t peer(1, shard_id_t::NO_SHARD);
+  ASSERT_FALSE(pf.has(peer));
+
+  pf.start(peer, mk_obj(10));
+  ASSERT_TRUE(pf.has(peer));
+  ASSERT_TRUE(pf.is_pending(peer));
+  ASSERT_EQ(mk_obj(10), pf.get_begin(peer));
+
+  // replies for other peers or ranges are not the prefetch
+  ASSERT_EQ(nullptr, pf.on_reply(pg_shard_t(2, shard_id_t::NO_SHARD),
+				 mk_obj(10)));
+  ASSERT_EQ(nullptr, pf.on_reply(peer, mk_obj(5)));
+  ASSERT_TRUE(pf.is_pending(peer));
+
+  BackfillInterval *bi = pf.on_reply(peer, mk_obj(10));
+  ASSERT_NE(nullptr, bi);
+  ASSERT_FALSE(pf.is_pending(peer));
+  bi->objects[mk_obj(11)] = eversion_t(1, 1);
+  bi->end = mk_obj(20);
+  // the reply is only taken once
+  ASSERT_EQ(nullptr, pf.on_reply(peer, mk_obj(10)));
+
+  BackfillInterval got = pf.take(peer);
+  ASSERT_FALSE(pf.has(peer));
+  ASSERT_EQ(mk_obj(10), got.begin);
+  ASSERT_EQ(mk_obj(20), got.end);
+  ASSERT_EQ(1u, got.objects.size());
+
+  // and a new one can be started for the next interval
+  pf.start(peer, got.end);
+  ASSERT_TRUE(pf.is_pending(peer));
+}
+
+TEST(BackfillPrefetch, discard_on_reset)
+{
+  BackfillPrefetch pf;
+  pg_shard_t a(1, shard_id_t::NO_SHARD), b(2, shard_id_t::NO_SHARD);
+  pf.start(a, mk_obj(10));
+  pf.start(b, mk_obj(10));
+
+  // the peer's interval no longer continues where the prefetch starts
+  pf.discard(a);
+  ASSERT_FALSE(pf.has(a));
+  ASSERT_FALSE(pf.is_pending(a));
+  ASSERT_TRUE(pf.is_pending(b));
+  // the reply to the discarded prefetch arrives late and is not used
+  ASSERT_EQ(nullptr, pf.on_reply(a, mk_obj(10)));
+  ASSERT_FALSE(pf.has(a));
+
+  // interval change or backfill restart: everything goes, including
+  // replies that already arrived
+  ASSERT_NE(nullptr, pf.on_reply(b, mk_obj(10)));
+  pf.start(a, mk_obj(30));
+  pf.clear();
+  ASSERT_FALSE(pf.has(a));
+  ASSERT_FALSE(pf.has(b));
+  ASSERT_EQ(nullptr, pf.on_reply(a, mk_obj(30)));
+
+  // a restarted backfill prefetching the same range again is unaffected
+  pf.start(a, mk_obj(30));
+  ASSERT_NE(nullptr, pf.on_reply(a, mk_obj(30)));
+  ASSERT_EQ(mk_obj(30), pf.take(a).begin);
+}
+
 /*
  * Local Variables:
  * compile-command: "cd ../.. ;
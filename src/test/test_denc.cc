@@ -267,6 +267,64 @@ TEST(denc, vector)
   }
 }
 
+TEST(denc, vector_memcpyable)
+{
+  static_assert(denc_memcpyable_v<ceph_le32>);
+  static_assert(denc_memcpyable_v<uint8_t>);
+  static_assert(!denc_memcpyable_v<bool>);
+  static_assert(!denc_memcpyable_v<std::string>);
+#ifndef CEPH_BIG_ENDIAN
+  static_assert(denc_memcpyable_v<uint32_t>);
+  static_assert(denc_memcpyable_v<int64_t>);
+  static_assert(denc_memcpyable_v<snapid_t>);
+#endif
+
+  vector<uint32_t> v;
+  for (uint32_t i = 0; i < 1000; ++i) {
+    v.push_back(i * 0x01010101u);
+  }
+  test_denc(v);
+  vector<snapid_t> snaps{1, 2, CEPH_NOSNAP};
+  test_denc(snaps);
+  test_denc(vector<uint64_t>{});
+
+  // same encoding as one element at a time
+  bufferlist bl, expected;
+  encode(v, bl);
+  encode((uint32_t)v.size(), expected);
+  for (auto i : v) {
+    encode(i, expected);
+  }
+  ASSERT_TRUE(bl.contents_equal(expected));
+
+  // from a segmented bufferlist
+  bufferlist segmented;
+  for (const auto& bp : bl.buffers()) {
+    for (unsigned off = 0; off < bp.length(); off += 7) {
+      segmented.append(bp.c_str() + off, std::min(7u, bp.length() - off));
+      segmented.append(bufferptr(buffer::create(0)));
+    }
+  }
+  {
+    vector<uint32_t> out;
+    auto p = segmented.cbegin();
+    decode(out, p);
+    ASSERT_EQ(v, out);
+  }
+
+  // a count beyond the end of the buffer
+  {
+    bufferlist truncated;
+    truncated.substr_of(bl, 0, bl.length() - 1);
+    vector<uint32_t> out;
+    auto p = truncated.cbegin();
+    ASSERT_THROW(decode(out, p), buffer::end_of_buffer);
+    truncated.rebuild();
+    auto bpi = truncated.front().cbegin();
+    ASSERT_THROW(denc(out, bpi), buffer::end_of_buffer);
+  }
+}
+
 template<typename T>
 using default_list = std::list<T>;
 
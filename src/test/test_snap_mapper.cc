@@ -541,6 +541,57 @@ public:
     snap_to_hobject.erase(snap);
   }
 
+  // leave the first object handed out untrimmed, as when its write
+  // lock is busy, and make sure the mapper still comes back to it
+  void trim_snap_skip_first() {
+    std::lock_guard l{lock};
+    if (snap_to_hobject.empty())
+      return;
+    map<snapid_t, set<hobject_t> >::iterator snap =
+      rand_choose(snap_to_hobject);
+    set<hobject_t> hobjects = snap->second;
+
+    hobject_t skipped;
+    unsigned seen_skipped = 0;
+    vector<hobject_t> hoids;
+    while (mapper->get_next_objects_to_trim(
+	     snap->first, rand() % 5 + 1, &hoids) == 0) {
+      for (auto &&hoid: hoids) {
+	ceph_assert(hobjects.count(hoid));
+	if (skipped == hobject_t()) {
+	  skipped = hoid;
+	}
+	if (hoid == skipped && seen_skipped++ == 0) {
+	  continue;
+	}
+	hobjects.erase(hoid);
+
+	map<hobject_t, set<snapid_t>>::iterator j =
+	  hobject_to_snap.find(hoid);
+	ceph_assert(j->second.count(snap->first));
+	set<snapid_t> old_snaps(j->second);
+	j->second.erase(snap->first);
+
+	{
+	  PausyAsyncMap::Transaction t;
+	  mapper->update_snaps(
+	    hoid,
+	    j->second,
+	    &old_snaps,
+	    &t);
+	  driver->submit(&t);
+	}
+	if (j->second.empty()) {
+	  hobject_to_snap.erase(j);
+	}
+      }
+      hoids.clear();
+    }
+    ceph_assert(hobjects.empty());
+    ceph_assert(skipped == hobject_t() || seen_skipped == 2);
+    snap_to_hobject.erase(snap);
+  }
+
   void remove_oid() {
     std::lock_guard l{lock};
     if (hobject_to_snap.empty())
@@ -646,6 +697,15 @@ TEST_F(SnapMapperTest, Simple) {
   get_tester().trim_snap();
 }
 
+TEST_F(SnapMapperTest, TrimRevisitsSkipped) {
+  init(1);
+  get_tester().create_snap();
+  for (int i = 0; i < 100; ++i) {
+    get_tester().create_object();
+  }
+  get_tester().trim_snap_skip_first();
+}
+
 TEST_F(SnapMapperTest, More) {
   init(1);
   run();
@@ -14,6 +14,7 @@
 
 
 #include <errno.h>
+#include <chrono>
 #include "ceph_ver.h"
 #include "include/types.h"
 #include "common/Formatter.h"
@@ -51,6 +52,8 @@ void usage(ostream &out)
   out << "  count_tests         print number of generated test objects (to stdout)\n";
   out << "  select_test <n>     select generated test object as in-memory object\n";
   out << "  is_deterministic    exit w/ success if type encodes deterministically\n";
+  out << "\n";
+  out << "  bench <n>           time encoding and decoding the in-memory object n times\n";
 }
   
 int main(int argc, const char **argv)
@@ -130,6 +133,37 @@ int main(int argc, const char **argv)
 	exit(1);
       }
       err = den->decode(encbl, skip);
+    } else if (*i == string("bench")) {
+      ++i;
+      if (i == args.end()) {
+	cerr << "expecting iteration count" << std::endl;
+	exit(1);
+      }
+      if (!den) {
+	cerr << "must first select type with 'type <name>'" << std::endl;
+	exit(1);
+      }
+      unsigned n = std::max(atoi(*i), 1);
+      bufferlist bl;
+      auto start = std::chrono::steady_clock::now();
+      for (unsigned k = 0; k < n; k++) {
+	den->encode(bl, features | CEPH_FEATURE_RESERVED);
+      }
+      std::chrono::duration<double, std::nano> enc_ns =
+	std::chrono::steady_clock::now() - start;
+      start = std::chrono::steady_clock::now();
+      for (unsigned k = 0; k < n; k++) {
+	err = den->decode(bl, 0);
+	if (err.length())
+	  break;
+      }
+      std::chrono::duration<double, std::nano> dec_ns =
+	std::chrono::steady_clock::now() - start;
+      if (err.empty()) {
+	cout << bl.length() << " bytes, "
+	     << enc_ns.count() / n << " ns/encode, "
+	     << dec_ns.count() / n << " ns/decode" << std::endl;
+      }
     } else if (*i == string("copy_ctor")) {
       if (!den) {
 	cerr << "must first select type with 'type <name>'" << std::endl;
@@ -4,6 +4,7 @@
 #include <map>
 #include <random>
 #include <boost/program_options.hpp>
+#include <boost/range/irange.hpp>
 
 #include <seastar/core/app-template.hh>
 #include <seastar/core/do_with.hh>
@@ -63,6 +64,7 @@ struct client_config {
   unsigned msgtime;
   unsigned jobs;
   unsigned depth;
+  unsigned server_ports;
   bool v1_crc_enabled;
 
   std::string str() const {
@@ -73,6 +75,7 @@ struct client_config {
         << ", msgtime=" << msgtime
         << ", jobs=" << jobs
         << ", depth=" << depth
+        << ", server-ports=" << server_ports
         << ", v1-crc-enabled=" << v1_crc_enabled
         << ")";
     return out.str();
@@ -90,15 +93,30 @@ struct client_config {
     conf.jobs = options["jobs"].as<unsigned>();
     conf.depth = options["depth"].as<unsigned>();
     ceph_assert(conf.depth % conf.jobs == 0);
+    // jobs are spread over the server messengers, see server_config
+    if (options["crosscore"].as<bool>()) {
+      conf.server_ports = 1;
+    } else {
+      conf.server_ports = options["server-shards"].as<unsigned>();
+    }
+    ceph_assert(conf.server_ports > 0);
     conf.v1_crc_enabled = options["v1-crc-enabled"].as<bool>();
     return conf;
   }
 };
 
+// The server runs on the shards [core, core + shards).  By default each
+// of them has its own messenger, listening on consecutive ports from
+// addr, so that a connection is accepted right on the shard serving it.
+// With crosscore, only the first shard listens and it hands every
+// request over to one of the server shards in turn, the way an OSD
+// forwards a request to the shard owning its PG.
 struct server_config {
   entity_addr_t addr;
   unsigned block_size;
   unsigned core;
+  unsigned shards;
+  bool crosscore;
   bool v1_crc_enabled;
 
   std::string str() const {
@@ -106,6 +124,8 @@ struct server_config {
     out << "server[" << addr
         << "](bs=" << block_size
         << ", core=" << core
+        << ", shards=" << shards
+        << ", crosscore=" << crosscore
         << ", v1-crc-enabled=" << v1_crc_enabled
         << ")";
     return out.str();
@@ -119,6 +139,9 @@ struct server_config {
     conf.addr = addr;
     conf.block_size = options["sbs"].as<unsigned>();
     conf.core = options["core"].as<unsigned>();
+    conf.shards = options["server-shards"].as<unsigned>();
+    ceph_assert(conf.shards > 0);
+    conf.crosscore = options["crosscore"].as<bool>();
     conf.v1_crc_enabled = options["v1-crc-enabled"].as<bool>();
     return conf;
   }
@@ -143,30 +166,59 @@ static seastar::future<> run(
       std::string lname;
       unsigned msg_len;
       bufferlist msg_data;
+      // requests are handled on the shards [msgr_sid, msgr_sid + nr_handlers)
+      const unsigned nr_handlers;
 
-      Server(unsigned msg_len)
+      Server(unsigned msg_len, unsigned nr_handlers)
         : msgr_sid{seastar::this_shard_id()},
-          msg_len{msg_len} {
+          msg_len{msg_len},
+          nr_handlers{nr_handlers} {
         lname = "server#";
         lname += std::to_string(msgr_sid);
         msg_data.append_zero(msg_len);
       }
 
-      seastar::future<> ms_dispatch(crimson::net::Connection* c,
-                                    MessageRef m) override {
-        ceph_assert(m->get_type() == CEPH_MSG_OSD_OP);
-
-        // server replies with MOSDOp to generate server-side write workload
+      // server replies with MOSDOp to generate server-side write workload
+      static MessageRef make_reply(ceph_tid_t tid, bufferlist data) {
         const static pg_t pgid;
         const static object_locator_t oloc;
         const static hobject_t hobj(object_t(), oloc.key, CEPH_NOSNAP, pgid.ps(),
                                     pgid.pool(), oloc.nspace);
         static spg_t spgid(pgid);
         auto rep = make_message<MOSDOp>(0, 0, hobj, spgid, 0, 0, 0);
-        bufferlist data(msg_data);
-        rep->write(0, msg_len, data);
-        rep->set_tid(m->get_tid());
-        return c->send(std::move(rep));
+        rep->write(0, data.length(), data);
+        rep->set_tid(tid);
+        return rep;
+      }
+
+      seastar::future<> ms_dispatch(crimson::net::Connection* c,
+                                    MessageRef m) override {
+        ceph_assert(m->get_type() == CEPH_MSG_OSD_OP);
+
+        seastar::shard_id sid = msgr_sid + m->get_tid() % nr_handlers;
+        if (sid == msgr_sid) {
+          return c->send(make_reply(m->get_tid(), msg_data));
+        }
+        // lend the connection and the request to the handling shard, and
+        // send the reply back from there, copying neither of them
+        return seastar::smp::submit_to(sid,
+            [conn = seastar::make_foreign(c->get_shared()),
+             m = seastar::make_foreign(std::move(m)),
+             msgr_sid = msgr_sid,
+             msg_len = msg_len] () mutable {
+          // the reply leaves this shard, so its payload may not be shared
+          // with anything staying here
+          bufferlist data;
+          data.append_zero(msg_len);
+          auto reply = make_reply(m->get_tid(), std::move(data));
+          // the connection may only be used on its own shard, the reply
+          // is moved there as is
+          auto p_conn = conn.get();
+          return seastar::smp::submit_to(msgr_sid,
+              [p_conn, reply = std::move(reply)] () mutable {
+            return p_conn->send(std::move(reply));
+          }).finally([conn = std::move(conn), m = std::move(m)] {});
+        });
       }
 
       seastar::future<> init(bool v1_crc_enabled, const entity_addr_t& addr) {
@@ -201,9 +253,54 @@ static seastar::future<> run(
         });
       }
 
-      static seastar::future<ServerFRef> create(seastar::shard_id msgr_sid, unsigned msg_len) {
-        return seastar::smp::submit_to(msgr_sid, [msg_len] {
-          return seastar::make_foreign(std::make_unique<Server>(msg_len));
+      static seastar::future<ServerFRef> create(seastar::shard_id msgr_sid,
+                                                unsigned msg_len,
+                                                unsigned nr_handlers) {
+        return seastar::smp::submit_to(msgr_sid, [msg_len, nr_handlers] {
+          return seastar::make_foreign(
+            std::make_unique<Server>(msg_len, nr_handlers));
+        });
+      }
+    };
+
+    struct ServerGroup {
+      std::vector<ServerFRef> servers;
+
+      static seastar::future<std::unique_ptr<ServerGroup>> create(
+          const server_config& conf) {
+        unsigned nr_msgrs = conf.crosscore ? 1 : conf.shards;
+        unsigned nr_handlers = conf.crosscore ? conf.shards : 1;
+        auto group = std::make_unique<ServerGroup>();
+        auto p_group = group.get();
+        return seastar::do_for_each(boost::irange(0u, nr_msgrs),
+            [p_group, core = conf.core, bs = conf.block_size, nr_handlers]
+            (unsigned i) {
+          return Server::create(core + i, bs, nr_handlers
+          ).then([p_group] (auto fp_server) {
+            p_group->servers.push_back(std::move(fp_server));
+          });
+        }).then([group = std::move(group)] () mutable {
+          return std::move(group);
+        });
+      }
+
+      seastar::future<> init(bool v1_crc_enabled, const entity_addr_t& addr) {
+        return seastar::do_for_each(boost::irange(size_t(0), servers.size()),
+            [this, v1_crc_enabled, addr] (size_t i) {
+          // one port for each server messenger
+          auto server_addr = addr;
+          server_addr.set_port(addr.get_port() + i);
+          return servers[i]->init(v1_crc_enabled, server_addr);
+        });
+      }
+      seastar::future<> shutdown() {
+        return seastar::do_for_each(servers, [] (auto& server) {
+          return server->shutdown();
+        });
+      }
+      seastar::future<> wait() {
+        return seastar::parallel_for_each(servers, [] (auto& server) {
+          return server->wait();
         });
       }
     };
@@ -364,12 +461,16 @@ static seastar::future<> run(
         });
       }
 
-      seastar::future<> connect_wait_verify(const entity_addr_t& peer_addr) {
-        return container().invoke_on_all([peer_addr] (auto& client) {
+      seastar::future<> connect_wait_verify(const entity_addr_t& peer_addr,
+                                            unsigned server_ports) {
+        return container().invoke_on_all([peer_addr, server_ports] (auto& client) {
           // start clients in active cores (#1 ~ #jobs)
           if (client.is_active()) {
             mono_time start_time = mono_clock::now();
-            client.active_conn = client.msgr->connect(peer_addr, entity_name_t::TYPE_OSD);
+            // spread the clients over the server messengers
+            auto addr = peer_addr;
+            addr.set_port(peer_addr.get_port() + (client.sid - 1) % server_ports);
+            client.active_conn = client.msgr->connect(addr, entity_name_t::TYPE_OSD);
             // make sure handshake won't hurt the performance
             return seastar::sleep(1s).then([&client, start_time] {
               if (client.conn_stats.connected_time == mono_clock::zero()) {
@@ -645,24 +746,26 @@ static seastar::future<> run(
   };
 
   return seastar::when_all(
-      test_state::Server::create(server_conf.core, server_conf.block_size),
+      test_state::ServerGroup::create(server_conf),
       create_sharded<test_state::Client>(client_conf.jobs, client_conf.block_size, client_conf.depth)
   ).then([=](auto&& ret) {
     auto fp_server = std::move(std::get<0>(ret).get0());
     auto client = std::move(std::get<1>(ret).get0());
-    test_state::Server* server = fp_server.get();
+    test_state::ServerGroup* server = fp_server.get();
     if (mode == perf_mode_t::both) {
       logger().info("\nperf settings:\n  {}\n  {}\n",
                     client_conf.str(), server_conf.str());
       ceph_assert(seastar::smp::count >= 1+client_conf.jobs);
       ceph_assert(client_conf.jobs > 0);
-      ceph_assert(seastar::smp::count >= 1+server_conf.core);
-      ceph_assert(server_conf.core == 0 || server_conf.core > client_conf.jobs);
+      ceph_assert(seastar::smp::count >= server_conf.core+server_conf.shards);
+      ceph_assert((server_conf.core == 0 && server_conf.shards == 1) ||
+                  server_conf.core > client_conf.jobs);
       return seastar::when_all_succeed(
         server->init(server_conf.v1_crc_enabled, server_conf.addr),
         client->init(client_conf.v1_crc_enabled)
-      ).then_unpack([client, addr = client_conf.server_addr] {
-        return client->connect_wait_verify(addr);
+      ).then_unpack([client, addr = client_conf.server_addr,
+                     ports = client_conf.server_ports] {
+        return client->connect_wait_verify(addr, ports);
       }).then([client, ramptime = client_conf.ramptime,
                msgtime = client_conf.msgtime] {
         return client->dispatch_with_timer(ramptime, msgtime);
@@ -676,8 +779,9 @@ static seastar::future<> run(
       ceph_assert(seastar::smp::count >= 1+client_conf.jobs);
       ceph_assert(client_conf.jobs > 0);
       return client->init(client_conf.v1_crc_enabled
-      ).then([client, addr = client_conf.server_addr] {
-        return client->connect_wait_verify(addr);
+      ).then([client, addr = client_conf.server_addr,
+              ports = client_conf.server_ports] {
+        return client->connect_wait_verify(addr, ports);
       }).then([client, ramptime = client_conf.ramptime,
                msgtime = client_conf.msgtime] {
         return client->dispatch_with_timer(ramptime, msgtime);
@@ -685,7 +789,7 @@ static seastar::future<> run(
         return client->shutdown();
       });
     } else { // mode == perf_mode_t::server
-      ceph_assert(seastar::smp::count >= 1+server_conf.core);
+      ceph_assert(seastar::smp::count >= server_conf.core+server_conf.shards);
       logger().info("\nperf settings:\n  {}\n", server_conf.str());
       return server->init(server_conf.v1_crc_enabled, server_conf.addr
       // dispatch ops
@@ -723,6 +827,11 @@ int main(int argc, char** argv)
      "server running core")
     ("sbs", bpo::value<unsigned>()->default_value(0),
      "server block size")
+    ("server-shards", bpo::value<unsigned>()->default_value(1),
+     "number of server cores, starting from the server running core")
+    ("crosscore", bpo::value<bool>()->default_value(false),
+     "accept on the server running core only, and hand requests over to "
+     "the other server cores")
     ("v1-crc-enabled", bpo::value<bool>()->default_value(false),
      "enable v1 CRC checks");
   return app.run(argc, argv, [&app] {
@@ -13,9 +13,11 @@
  */
 
 #include <string>
+#include <thread>
 #include <sys/stat.h>
 
 #include "common/ceph_argparse.h"
+#include "common/ceph_json.h"
 #include "common/errno.h"
 #include "common/safe_io.h"
 #include "mon/health_check.h"
@@ -24,6 +26,7 @@
 
 #include "global/global_init.h"
 #include "osd/OSDMap.h"
+#include "osd/OSDMapMapping.h"
 
 
 void usage()
@@ -61,6 +64,17 @@ void usage()
   cout << "   --dump <format>         displays the map in plain text when <format> is 'plain', 'json' if specified format is not supported" << std::endl;
   cout << "   --tree                  displays a tree of the map" << std::endl;
   cout << "   --test-crush [--range-first <first> --range-last <last>] map pgs to acting osds" << std::endl;
+  cout << "   --adjust-crush-weight <osdid:weight>[,<osdid:weight>,<...>] change <osdid> CRUSH <weight> (but do not persist)" << std::endl;
+  cout << "   --preview-pg-movement   show which pgs the other changes requested" << std::endl;
+  cout << "                           (--import-crush, --adjust-crush-weight, --mark-out," << std::endl;
+  cout << "                           --upmap, ...) would move; the map is never written," << std::endl;
+  cout << "                           so --upmap-save cannot be combined with it" << std::endl;
+  cout << "   --pg-stats <file>       'ceph pg dump --format json' output used by" << std::endl;
+  cout << "                           --preview-pg-movement to estimate bytes moved" << std::endl;
+  cout << "   --preview-threads <n>   threads used to map pgs [default: number of cpus]" << std::endl;
+  cout << "   --preview-json          dump the --preview-pg-movement result as json" << std::endl;
+  cout << "   --test-incremental-mapping  time the full and the incremental pg" << std::endl;
+  cout << "                           mapping update for marking one osd down" << std::endl;
   exit(1);
 }
 
@@ -150,6 +164,12 @@ int main(int argc, const char **argv)
   std::set<std::string> upmap_pools;
   int64_t pg_num = -1;
   bool test_map_pgs_dump_all = false;
+  std::map<int, double> adjust_crush_weight;
+  bool preview_pg_movement = false;
+  bool preview_json = false;
+  std::string pg_stats_file;
+  int preview_threads = std::max(1u, std::thread::hardware_concurrency());
+  bool test_incremental_mapping = false;
 
   std::string val;
   std::ostringstream err;
@@ -238,6 +258,39 @@ int main(int argc, const char **argv)
         cerr << "error parsing integer value " << interr << std::endl;
         exit(EXIT_FAILURE);
       }
+    } else if (ceph_argparse_witharg(args, i, &val, "--adjust-crush-weight", (char*)NULL)) {
+      vector<string> pairs;
+      get_str_vec(val, ",", pairs);
+      for (auto& p : pairs) {
+	auto colon = p.find(':');
+	string interr;
+	int osd = strict_strtol(p.substr(0, colon).c_str(), 10, &interr);
+	string floaterr;
+	double weight = colon == string::npos ? 0 :
+	  strict_strtod(p.substr(colon + 1).c_str(), &floaterr);
+	if (colon == string::npos || !interr.empty() || !floaterr.empty() ||
+	    osd < 0 || weight < 0) {
+	  cerr << "invalid --adjust-crush-weight pair '" << p << "'" << std::endl;
+	  exit(EXIT_FAILURE);
+	}
+	adjust_crush_weight[osd] = weight;
+      }
+    } else if (ceph_argparse_flag(args, i, "--preview-pg-movement", (char*)NULL)) {
+      preview_pg_movement = true;
+    } else if (ceph_argparse_flag(args, i, "--preview-json", (char*)NULL)) {
+      preview_json = true;
+    } else if (ceph_argparse_flag(args, i, "--test-incremental-mapping", (char*)NULL)) {
+      test_incremental_mapping = true;
+    } else if (ceph_argparse_witharg(args, i, &pg_stats_file, "--pg-stats", (char*)NULL)) {
+    } else if (ceph_argparse_witharg(args, i, &preview_threads, err, "--preview-threads", (char*)NULL)) {
+      if (!err.str().empty()) {
+        cerr << err.str() << std::endl;
+        exit(EXIT_FAILURE);
+      }
+      if (preview_threads < 1) {
+        cerr << "--preview-threads must be >= 1" << std::endl;
+        exit(EXIT_FAILURE);
+      }
     } else if (ceph_argparse_witharg(args, i, &range_first, err, "--range_first", (char*)NULL)) {
     } else if (ceph_argparse_witharg(args, i, &range_last, err, "--range_last", (char*)NULL)) {
     } else if (ceph_argparse_witharg(args, i, &pool, err, "--pool", (char*)NULL)) {
@@ -261,6 +314,13 @@ int main(int argc, const char **argv)
     cerr << me << ": upmap-deviation must be >= 1" << std::endl;
     usage();
   }
+  if (preview_pg_movement &&
+      (upmap_save || createsimple || create_from_conf)) {
+    cerr << me << ": --preview-pg-movement never writes the map, it cannot be"
+	 << " combined with --upmap-save, --createsimple or --create-from-conf"
+	 << std::endl;
+    usage();
+  }
   fn = args[0];
 
   if (range_first >= 0 && range_last >= 0) {
@@ -335,6 +395,14 @@ int main(int argc, const char **argv)
     modified = true;
   }
 
+  // keep the unmodified map around to compare against
+  OSDMap preview_base;
+  if (preview_pg_movement) {
+    bufferlist pbl;
+    osdmap.encode(pbl, CEPH_FEATURES_SUPPORTED_DEFAULT | CEPH_FEATURE_RESERVED);
+    preview_base.decode(pbl);
+  }
+
   if (mark_up_in) {
     cout << "marking all OSDs up and in" << std::endl;
     int n = osdmap.get_max_osd();
@@ -353,6 +421,17 @@ int main(int argc, const char **argv)
     osdmap.crush->adjust_item_weightf(g_ceph_context, id, 1.0);
   }
 
+  for (auto& [osd, weight] : adjust_crush_weight) {
+    if (!osdmap.crush->item_exists(osd)) {
+      cerr << me << ": osd." << osd << " does not exist in the crush map"
+	   << std::endl;
+      exit(1);
+    }
+    cout << "adjusting osd." << osd << " crush weight to " << weight
+	 << std::endl;
+    osdmap.crush->adjust_item_weightf(g_ceph_context, osd, weight);
+  }
+
   if (clear_temp) {
     cout << "clearing pg/primary temp" << std::endl;
     osdmap.clear_temp();
@@ -446,7 +525,7 @@ int main(int argc, const char **argv)
         cout << "Time elapsed " << elapsed_time << " secs" << std::endl;
       if (total_did > 0) {
         print_inc_upmaps(pending_inc, upmap_fd);
-        if (upmap_save || upmap_active) {
+        if (upmap_save || upmap_active || preview_pg_movement) {
 	  int r = osdmap.apply_incremental(pending_inc);
 	  ceph_assert(r == 0);
 	  if (upmap_save)
@@ -725,7 +804,138 @@ skip_upmap:
     }
   }
 
-  if (!print && !health && !tree && !modified &&
+  if (preview_pg_movement) {
+    std::map<pg_t,uint64_t> pg_bytes;
+    if (!pg_stats_file.empty()) {
+      JSONParser parser;
+      if (!parser.parse(pg_stats_file.c_str())) {
+	cerr << me << ": unable to parse pg stats from " << pg_stats_file
+	     << std::endl;
+	exit(1);
+      }
+      // 'pg dump' nests the stats under pg_map, 'pg dump pgs' does not
+      JSONObj *stats_parent = &parser;
+      if (JSONObj *pg_map = parser.find_obj("pg_map")) {
+	stats_parent = pg_map;
+      }
+      JSONObj *pg_stats = stats_parent->find_obj("pg_stats");
+      if (!pg_stats) {
+	cerr << me << ": no pg_stats in " << pg_stats_file << std::endl;
+	exit(1);
+      }
+      for (auto it = pg_stats->find_first(); !it.end(); ++it) {
+	string pgid_str;
+	uint64_t num_bytes = 0;
+	JSONObj *stat_sum = (*it)->find_obj("stat_sum");
+	pg_t pgid;
+	if (!JSONDecoder::decode_json("pgid", pgid_str, *it) ||
+	    !stat_sum ||
+	    !JSONDecoder::decode_json("num_bytes", num_bytes, stat_sum) ||
+	    !pgid.parse(pgid_str.c_str())) {
+	  continue;
+	}
+	pg_bytes[pgid] = num_bytes;
+      }
+      cout << "loaded stats for " << pg_bytes.size() << " pgs from "
+	   << pg_stats_file << std::endl;
+    }
+
+    ThreadPool tp(g_ceph_context, "osdmaptool::preview", "tp_preview",
+		  preview_threads);
+    tp.start();
+    ParallelPGMapper mapper(g_ceph_context, &tp);
+    PGMovementPreview preview;
+    utime_t start = ceph_clock_now();
+    preview.compute(preview_base, osdmap, mapper,
+		    g_conf()->mon_osd_mapping_pgs_per_chunk);
+    utime_t elapsed = ceph_clock_now() - start;
+    tp.stop();
+
+    auto bytes_arg = pg_stats_file.empty() ? nullptr : &pg_bytes;
+    if (preview_json) {
+      JSONFormatter jf(true);
+      jf.open_object_section("pg_movement");
+      preview.dump(&jf, bytes_arg);
+      jf.close_section();
+      jf.flush(cout);
+      cout << std::endl;
+    } else {
+      for (auto& [pgid, m] : preview.moves) {
+	cout << pgid << "\t" << m.from << " -> " << m.to
+	     << "\tshards " << m.shards;
+	if (bytes_arg) {
+	  auto p = pg_bytes.find(pgid);
+	  if (p != pg_bytes.end()) {
+	    cout << "\tbytes " << p->second / m.data_shards * m.shards;
+	  }
+	}
+	cout << std::endl;
+      }
+      cout << "moved " << preview.moves.size() << "/" << preview.num_pgs
+	   << " pgs, " << preview.num_shards << " shards" << std::endl;
+      if (bytes_arg) {
+	uint64_t unknown = 0;
+	uint64_t bytes = preview.estimate_bytes(pg_bytes, &unknown);
+	cout << "estimated " << byte_u_t(bytes) << " moved";
+	if (unknown) {
+	  cout << " (" << unknown << " moved pgs have no stats)";
+	}
+	cout << std::endl;
+      }
+    }
+    cerr << "mapped with " << preview_threads << " threads in " << elapsed
+	 << " secs" << std::endl;
+    // a preview never writes the proposed map out; --upmap-save and
+    // the create options were rejected above, so this only drops the
+    // changes made for the preview itself (--import-crush, --mark-out...)
+    modified = false;
+  }
+
+  if (test_incremental_mapping) {
+    // what the monitor does for an epoch that only marks an osd down:
+    // recompute every pg, or only those the osd is mapped to
+    int osd = -1;
+    for (int o = 0; o < osdmap.get_max_osd(); ++o) {
+      if (osdmap.is_up(o)) {
+	osd = o;
+	break;
+      }
+    }
+    if (osd < 0) {
+      cerr << me << ": no osd is up, try --mark-up-in" << std::endl;
+      exit(1);
+    }
+    OSDMapMapping mapping;
+    mapping.update(osdmap);
+    OSDMap next;
+    next.deepish_copy_from(osdmap);
+    OSDMap::Incremental inc(next.get_epoch() + 1);
+    inc.fsid = next.get_fsid();
+    inc.new_state[osd] = CEPH_OSD_UP;
+    next.apply_incremental(inc);
+
+    utime_t start = ceph_clock_now();
+    OSDMapMapping full;
+    full.update(next);
+    utime_t full_elapsed = ceph_clock_now() - start;
+
+    start = ceph_clock_now();
+    set<pg_t> pgs;
+    if (!next.get_incremental_mapping_pgs(inc, mapping, &pgs)) {
+      cerr << me << ": incremental mapping not possible" << std::endl;
+      exit(1);
+    }
+    mapping.update(next, pgs);
+    utime_t inc_elapsed = ceph_clock_now() - start;
+
+    cout << "marking osd." << osd << " down remaps " << pgs.size() << "/"
+	 << full.get_num_pgs() << " pgs" << std::endl;
+    cout << "full update " << full_elapsed << " secs, incremental update "
+	 << inc_elapsed << " secs" << std::endl;
+  }
+
+  if (!print && !health && !tree && !modified && !preview_pg_movement &&
+      !test_incremental_mapping &&
       export_crush.empty() && import_crush.empty() && 
       test_map_pg.empty() && test_map_object.empty() &&
       !test_map_pgs && !test_map_pgs_dump && !test_map_pgs_dump_all &&